@@ -1,13 +1,16 @@
 BENCHMARK_BUILD_DIR := $(BUILD_DIR)/benches
+PERF_BUILD_DIR := $(BUILD_DIR)/perf
 
 BENCHMARK_DIR := benches
 BENCHMARK_SOURCES := $(wildcard $(BENCHMARK_DIR)/*.cpp)
 BENCHMARK_HEADERS := $(wildcard $(BENCHMARK_DIR)/*.hpp)
 BENCHMARK_OBJECTS := $(addprefix $(BENCHMARK_BUILD_DIR)/, $(notdir $(patsubst %.cpp,%.o,$(BENCHMARK_SOURCES))))
-BENCHMARK_LINK_FLAGS := -lbenchmark -lbenchmark_main -lpthread
+BENCHMARK_LINK_FLAGS := -lbenchmark -lbenchmark_main -lpthread $(NUMA_LINK_FLAGS)
 BENCHMARK_BINARY := $(BENCHMARK_BUILD_DIR)/bench.out
-PERF_LINK_FLAGS := -lbenchmark -lbenchmark_main -lpfm -lpthread
-PERF_BINARY := $(BENCHMARK_BUILD_DIR)/perf.out
+# Benchmarks built for `make perf` also count instructions, LLC, dTLB and branch misses per item, using `perf_event_open`, see `perf_counters_t`.
+PERF_OBJECTS := $(addprefix $(PERF_BUILD_DIR)/, $(notdir $(patsubst %.cpp,%.o,$(BENCHMARK_SOURCES))))
+PERF_LINK_FLAGS := -lbenchmark -lbenchmark_main -lpfm -lpthread $(NUMA_LINK_FLAGS)
+PERF_BINARY := $(PERF_BUILD_DIR)/perf.out
 BENCHMARK_OUT_FILE := bench_result_on_$(shell uname -s)_$(shell uname -r)_$(shell uname -m)_with_$(CXX)_$(shell $(CXX) -dumpversion).json
 
 $(BENCHMARK_BUILD_DIR):
@@ -16,6 +19,12 @@ $(BENCHMARK_BUILD_DIR):
 $(BENCHMARK_BUILD_DIR)/%.o: $(BENCHMARK_DIR)/%.cpp $(BENCHMARK_BUILD_DIR) $(SHA3_INC_DIR)
 	$(CXX) $(CXX_DEFS) $(CXX_FLAGS) $(WARN_FLAGS) $(RELEASE_FLAGS) $(I_FLAGS) $(DEP_IFLAGS) -c $< -o $@
 
+$(PERF_BUILD_DIR):
+	mkdir -p $@
+
+$(PERF_BUILD_DIR)/%.o: $(BENCHMARK_DIR)/%.cpp $(PERF_BUILD_DIR) $(SHA3_INC_DIR)
+	$(CXX) $(CXX_DEFS) -DBFF_FOR_KV_MAP_PERF_COUNTERS $(CXX_FLAGS) $(WARN_FLAGS) $(RELEASE_FLAGS) $(I_FLAGS) $(DEP_IFLAGS) -c $< -o $@
+
 $(BENCHMARK_BINARY): $(BENCHMARK_OBJECTS)
 	$(CXX) $(RELEASE_FLAGS) $(LINK_OPT_FLAGS) $^ $(BENCHMARK_LINK_FLAGS) -o $@
 
@@ -23,9 +32,9 @@ benchmark: $(BENCHMARK_BINARY) ## Build and run all benchmarks, without libPFM -
 	# Must *not* build google-benchmark with libPFM
 	./$< --benchmark_min_warmup_time=.5 --benchmark_repetitions=10 --benchmark_min_time=0.5s --benchmark_display_aggregates_only=true --benchmark_report_aggregates_only=true --benchmark_counters_tabular=true --benchmark_out_format=json --benchmark_out=$(BENCHMARK_OUT_FILE)
 
-$(PERF_BINARY): $(BENCHMARK_OBJECTS)
+$(PERF_BINARY): $(PERF_OBJECTS)
 	$(CXX) $(RELEASE_FLAGS) $(LINK_OPT_FLAGS) $^ $(PERF_LINK_FLAGS) -o $@
 
-perf: $(PERF_BINARY) ## Build and run all benchmarks, while also collecting libPFM -based CPU CYCLE counter statistics
+perf: $(PERF_BINARY) ## Build and run all benchmarks, while also collecting libPFM -based CPU CYCLE counter statistics, and per item instruction, LLC, dTLB and branch miss counts
 	# Must build google-benchmark with libPFM, follow https://gist.github.com/itzmeanjan/05dc3e946f635d00c5e0b21aae6203a7
 	./$< --benchmark_min_warmup_time=.5 --benchmark_repetitions=10 --benchmark_min_time=0.5s --benchmark_display_aggregates_only=true --benchmark_report_aggregates_only=true --benchmark_counters_tabular=true --benchmark_perf_counters=CYCLES --benchmark_out_format=json --benchmark_out=$(BENCHMARK_OUT_FILE)
@@ -0,0 +1,181 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/build_budget.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include <algorithm>
+#include <atomic>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+constexpr size_t NUM_SERVED_KEYS = 1'000'000;
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+// Each latency sample times a batch of these many recovers, so that timer overhead stays small.
+constexpr size_t QUERY_BATCH_SIZE = 16;
+// For how long queries are served, when no filter is being built alongside.
+constexpr auto IDLE_QUERY_DURATION = std::chrono::milliseconds(500);
+// Budget of filters built in background, which run for half the time, on a single thread, zeroing scratch space with non-temporal stores.
+constexpr bff_kv_map::build_budget_t BACKGROUND_BUILD_BUDGET{ .cpu_fraction = 0.5, .max_num_threads = 1, .use_non_temporal_stores = true };
+
+// Whether, and how, a filter is built, while queries are served.
+enum class construction_mode_t : int64_t
+{
+  idle,
+  flat_out,
+  background,
+};
+
+// A filter serving queries, along with its keys, in random order, which is built once and shared by all benchmarks in this file.
+struct served_filter_t
+{
+  bff_kv_map::bff_for_kv_map_t filter;
+  std::vector<bff_kv_map_utils::bff_key_t> keys;
+};
+
+static const served_filter_t&
+get_served_filter()
+{
+  static const served_filter_t served_filter = []() {
+    served_filter_t served_filter{};
+
+    served_filter.keys = std::vector<bff_kv_map_utils::bff_key_t>(NUM_SERVED_KEYS);
+    std::vector<uint32_t> values(NUM_SERVED_KEYS, 0);
+    generate_random_keys_and_values(served_filter.keys, values, PLAINTEXT_MODULO);
+
+    bool is_constructed = false;
+    while (!is_constructed) {
+      try {
+        served_filter.filter = bff_kv_map::bff_for_kv_map_t(generate_random_seed(), served_filter.keys, values, PLAINTEXT_MODULO, LABEL);
+        is_constructed = true;
+      } catch (std::runtime_error& err) {
+      }
+    }
+
+    std::shuffle(served_filter.keys.begin(), served_filter.keys.end(), std::mt19937_64(NUM_SERVED_KEYS));
+    return served_filter;
+  }();
+
+  return served_filter;
+}
+
+// Serves queries against a filter, while another filter, over given number of keys, is built on a separate thread, either flat out or in background,
+// within a build budget. Reports median and tail latency of a query, along with time taken to build.
+static void
+bench_recover_during_construction_of_bff_for_kv_map(benchmark::State& state)
+{
+  const auto& served_filter = get_served_filter();
+
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+  const auto mode = static_cast<construction_mode_t>(state.range(1));
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint32_t> values(num_keys_in_kv_map, 0);
+  generate_random_keys_and_values(keys, values, PLAINTEXT_MODULO);
+
+  std::vector<double> query_latencies;
+  double build_ms = 0.;
+  size_t key_idx = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    std::atomic<bool> is_built{ false };
+    std::jthread builder;
+
+    const auto build_begin = std::chrono::steady_clock::now();
+    if (mode != construction_mode_t::idle) {
+      builder = std::jthread([&]() {
+        try {
+          if (mode == construction_mode_t::background) {
+            bff_kv_map::bff_for_kv_map_t filter(generate_random_seed(), keys, values, PLAINTEXT_MODULO, LABEL, BACKGROUND_BUILD_BUDGET);
+            benchmark::DoNotOptimize(filter);
+          } else {
+            bff_kv_map::bff_for_kv_map_t filter(generate_random_seed(), keys, values, PLAINTEXT_MODULO, LABEL);
+            benchmark::DoNotOptimize(filter);
+          }
+        } catch (std::runtime_error& err) {
+        }
+
+        is_built.store(true, std::memory_order_release);
+      });
+    }
+
+    const auto is_serving = [&]() {
+      if (mode == construction_mode_t::idle) {
+        return (std::chrono::steady_clock::now() - build_begin) < IDLE_QUERY_DURATION;
+      }
+
+      return !is_built.load(std::memory_order_acquire);
+    };
+
+    uint32_t value = 0;
+    while (is_serving()) {
+      const auto begin = std::chrono::steady_clock::now();
+      for (size_t i = 0; i < QUERY_BATCH_SIZE; i++) {
+        value ^= served_filter.filter.recover(served_filter.keys[key_idx]);
+        key_idx = (key_idx + 1) % served_filter.keys.size();
+      }
+      const auto end = std::chrono::steady_clock::now();
+
+      query_latencies.push_back(std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(QUERY_BATCH_SIZE));
+    }
+
+    builder = std::jthread();
+    build_ms += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - build_begin).count();
+
+    benchmark::DoNotOptimize(value);
+  }
+
+  perf_counters.report_per_item(static_cast<double>(query_latencies.size() * QUERY_BATCH_SIZE));
+
+  std::sort(query_latencies.begin(), query_latencies.end());
+
+  state.counters["p50_ns"] = query_latencies[query_latencies.size() / 2];
+  state.counters["p99_ns"] = query_latencies[(query_latencies.size() * 99) / 100];
+  state.counters["p999_ns"] = query_latencies[(query_latencies.size() * 999) / 1000];
+  if (mode != construction_mode_t::idle) {
+    state.counters["build_ms"] = build_ms / static_cast<double>(state.iterations());
+  }
+  state.SetItemsProcessed(static_cast<int64_t>(query_latencies.size() * QUERY_BATCH_SIZE));
+}
+
+BENCHMARK(bench_recover_during_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/recover during construction/1M Keys/Idle")
+  ->Args({ 1'000'000, static_cast<int64_t>(construction_mode_t::idle) })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_during_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/recover during construction/1M Keys/Flat Out")
+  ->Args({ 1'000'000, static_cast<int64_t>(construction_mode_t::flat_out) })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_during_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/recover during construction/1M Keys/Background")
+  ->Args({ 1'000'000, static_cast<int64_t>(construction_mode_t::background) })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_during_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/recover during construction/10M Keys/Flat Out")
+  ->Args({ 10'000'000, static_cast<int64_t>(construction_mode_t::flat_out) })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kSecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_during_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/recover during construction/10M Keys/Background")
+  ->Args({ 10'000'000, static_cast<int64_t>(construction_mode_t::background) })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kSecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
@@ -0,0 +1,169 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/filter_set_for_kv_map.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <fstream>
+#include <unistd.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+
+constexpr size_t NUM_TENANTS = 200'000;
+constexpr size_t NUM_KEYS_PER_TENANT = 16;
+constexpr size_t NUM_QUERIES = 1UL << 16;
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+
+// Returns resident set size of this process in bytes, after returning freed heap memory to the OS, where possible.
+static size_t
+resident_set_size()
+{
+#ifdef __GLIBC__
+  malloc_trim(0);
+#endif
+
+  size_t num_pages = 0, num_resident_pages = 0;
+
+  std::ifstream statm("/proc/self/statm");
+  statm >> num_pages >> num_resident_pages;
+
+  return num_resident_pages * static_cast<size_t>(sysconf(_SC_PAGESIZE));
+}
+
+// Generates keys and values of a tenant's Key-Value Map, deterministically from the tenant index, so that queries can be regenerated.
+static void
+generate_tenant_keys_and_values(const size_t tenant_idx, std::span<bff_kv_map_utils::bff_key_t> keys, std::span<uint32_t> values)
+{
+  for (size_t i = 0; i < keys.size(); i++) {
+    const uint64_t word = bff_kv_map_utils::murmur64((tenant_idx * NUM_KEYS_PER_TENANT) + i + 1);
+
+    keys[i].words = { word, bff_kv_map_utils::murmur64(word), tenant_idx, i };
+    values[i] = static_cast<uint32_t>(word % PLAINTEXT_MODULO);
+  }
+}
+
+// Generates queries, spread over all tenants, as (tenant index, key) pairs.
+static std::vector<std::pair<uint32_t, bff_kv_map_utils::bff_key_t>>
+generate_queries()
+{
+  std::vector<std::pair<uint32_t, bff_kv_map_utils::bff_key_t>> queries(NUM_QUERIES);
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(NUM_KEYS_PER_TENANT);
+  std::vector<uint32_t> values(NUM_KEYS_PER_TENANT, 0);
+
+  for (size_t query_idx = 0; query_idx < NUM_QUERIES; query_idx++) {
+    const uint64_t word = bff_kv_map_utils::murmur64(query_idx + 1);
+    const auto tenant_idx = static_cast<uint32_t>(word % NUM_TENANTS);
+
+    generate_tenant_keys_and_values(tenant_idx, keys, values);
+    queries[query_idx] = { tenant_idx, keys[(word >> 32) % NUM_KEYS_PER_TENANT] };
+  }
+
+  return queries;
+}
+
+static void
+bench_recover_from_separate_bff_for_kv_maps(benchmark::State& state)
+{
+  const auto seed = generate_random_seed();
+  const auto queries = generate_queries();
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(NUM_KEYS_PER_TENANT);
+  std::vector<uint32_t> values(NUM_KEYS_PER_TENANT, 0);
+
+  const size_t rss_before = resident_set_size();
+
+  std::vector<bff_kv_map::bff_for_kv_map_t> filters;
+  filters.reserve(NUM_TENANTS);
+
+  for (size_t tenant_idx = 0; tenant_idx < NUM_TENANTS; tenant_idx++) {
+    generate_tenant_keys_and_values(tenant_idx, keys, values);
+    filters.emplace_back(seed, keys, values, PLAINTEXT_MODULO, LABEL);
+  }
+
+  const size_t rss_after = resident_set_size();
+
+  size_t query_idx = 0;
+  uint32_t value = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filters);
+    benchmark::DoNotOptimize(query_idx);
+    benchmark::DoNotOptimize(value);
+
+    const auto& [tenant_idx, key] = queries[query_idx];
+    value ^= filters[tenant_idx].recover(key);
+
+    benchmark::ClobberMemory();
+
+    query_idx++;
+    query_idx %= queries.size();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["rss_bytes_per_filter"] = static_cast<double>(rss_after - rss_before) / static_cast<double>(NUM_TENANTS);
+}
+
+static void
+bench_recover_from_bff_for_kv_map_set(benchmark::State& state)
+{
+  const auto seed = generate_random_seed();
+  auto queries = generate_queries();
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(NUM_KEYS_PER_TENANT);
+  std::vector<uint32_t> values(NUM_KEYS_PER_TENANT, 0);
+  std::vector<uint32_t> handles(NUM_TENANTS, 0);
+
+  const size_t rss_before = resident_set_size();
+
+  bff_kv_map::bff_for_kv_map_set_t filter_set;
+
+  for (size_t tenant_idx = 0; tenant_idx < NUM_TENANTS; tenant_idx++) {
+    generate_tenant_keys_and_values(tenant_idx, keys, values);
+    handles[tenant_idx] = filter_set.add(seed, keys, values, PLAINTEXT_MODULO, LABEL);
+  }
+
+  const size_t rss_after = resident_set_size();
+
+  // Callers hold on to handles, just like they'd hold on to indices of separate filters.
+  for (auto& [tenant_idx, _] : queries) {
+    tenant_idx = handles[tenant_idx];
+  }
+
+  size_t query_idx = 0;
+  uint32_t value = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter_set);
+    benchmark::DoNotOptimize(query_idx);
+    benchmark::DoNotOptimize(value);
+
+    const auto& [handle, key] = queries[query_idx];
+    value ^= filter_set.recover(handle, key);
+
+    benchmark::ClobberMemory();
+
+    query_idx++;
+    query_idx %= queries.size();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["rss_bytes_per_filter"] = static_cast<double>(rss_after - rss_before) / static_cast<double>(NUM_TENANTS);
+}
+
+BENCHMARK(bench_recover_from_separate_bff_for_kv_maps)
+  ->Name("bff_for_kv_map/recover_across_tenants/200K Filters of 16 Keys")
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_bff_for_kv_map_set)
+  ->Name("bff_for_kv_map_set/recover_across_tenants/200K Filters of 16 Keys")
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
@@ -1,12 +1,140 @@
 #pragma once
 #include "binary_fuse_filter/utils.hpp"
 #include <algorithm>
+#include <array>
+#include <benchmark/benchmark.h>
 #include <cstdint>
 #include <random>
 #include <vector>
 
+#if defined(BFF_FOR_KV_MAP_PERF_COUNTERS)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
 constexpr auto compute_min = [](const std::vector<double>& v) -> double { return *std::min_element(v.begin(), v.end()); };
 constexpr auto compute_max = [](const std::vector<double>& v) -> double { return *std::max_element(v.begin(), v.end()); };
+constexpr auto compute_p99 = [](const std::vector<double>& v) -> double {
+  auto sorted = v;
+  std::sort(sorted.begin(), sorted.end());
+  return sorted[((sorted.size() * 99) + 99) / 100 - 1];
+};
+
+// Counts hardware events, from its construction till `report_per_item`, on the calling thread and threads it spawns meanwhile, and reports them as
+// benchmark counters, normalized per item i.e. per key recovered or built. Counting must be paused along with timing, around setup done within the
+// benchmark loop, see `pause` and `resume`. Only compiled in with `BFF_FOR_KV_MAP_PERF_COUNTERS`, as done by
+// `make perf`, otherwise it's a no-op. Events which can't be opened, e.g. for lack of a PMU or permission, are left out of the report.
+struct perf_counters_t
+{
+#if defined(BFF_FOR_KV_MAP_PERF_COUNTERS)
+private:
+  struct event_t
+  {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+  };
+
+  static constexpr std::array<event_t, 4> events{ {
+    { "instructions_per_item", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { "llc_misses_per_item", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+    { "dtlb_misses_per_item",
+      PERF_TYPE_HW_CACHE,
+      PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { "branch_misses_per_item", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+  } };
+
+  benchmark::State& state;
+  std::array<int, events.size()> fds{};
+
+public:
+  explicit perf_counters_t(benchmark::State& state)
+    : state(state)
+  {
+    for (size_t i = 0; i < events.size(); i++) {
+      perf_event_attr attr{};
+      attr.size = sizeof(attr);
+      attr.type = events[i].type;
+      attr.config = events[i].config;
+      attr.disabled = 1;
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+      fds[i] = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+
+    for (const int fd : fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  perf_counters_t(const perf_counters_t&) = delete;
+  perf_counters_t& operator=(const perf_counters_t&) = delete;
+
+  ~perf_counters_t()
+  {
+    for (const int fd : fds) {
+      if (fd >= 0) {
+        close(fd);
+      }
+    }
+  }
+
+  // Stops counting, until `resume` is called, e.g. while timing is paused. Neither enabled nor running time of events advances meanwhile.
+  void pause()
+  {
+    for (const int fd : fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+      }
+    }
+  }
+
+  // Resumes counting, after `pause`.
+  void resume()
+  {
+    for (const int fd : fds) {
+      if (fd >= 0) {
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+      }
+    }
+  }
+
+  // Stops counting, and reports each event divided by given number of items, scaled up for the time it wasn't counted, when events are multiplexed.
+  void report_per_item(const double num_items)
+  {
+    pause();
+
+    for (size_t i = 0; i < events.size(); i++) {
+      std::array<uint64_t, 3> value_enabled_running{};
+      if ((fds[i] < 0) || (read(fds[i], value_enabled_running.data(), sizeof(value_enabled_running)) != sizeof(value_enabled_running))) {
+        continue;
+      }
+
+      const auto [value, time_enabled, time_running] = value_enabled_running;
+      if (time_running == 0) {
+        continue;
+      }
+
+      const double scaled_value = static_cast<double>(value) * (static_cast<double>(time_enabled) / static_cast<double>(time_running));
+      state.counters[events[i].name] = scaled_value / num_items;
+    }
+  }
+#else
+public:
+  explicit perf_counters_t(benchmark::State&) {}
+  void pause() {}
+  void resume() {}
+  void report_per_item(const double) {}
+#endif
+};
 
 static inline std::array<uint8_t, 32>
 generate_random_seed()
@@ -44,3 +172,24 @@ generate_random_keys_and_values(std::span<bff_kv_map_utils::bff_key_t> keys, std
     value = dist_u32(gen);
   }
 }
+
+// Generates random keys and wide values, each of given bit width.
+static inline void
+generate_random_keys_and_wide_values(std::span<bff_kv_map_utils::bff_key_t> keys, std::span<uint64_t> values, const uint32_t value_bit_width)
+{
+  std::random_device rd;
+  std::mt19937_64 gen(rd());
+
+  std::uniform_int_distribution<uint64_t> dist_u64;
+
+  for (auto& key : keys) {
+    key.words[0] = dist_u64(gen);
+    key.words[1] = dist_u64(gen);
+    key.words[2] = dist_u64(gen);
+    key.words[3] = dist_u64(gen);
+  }
+
+  for (auto& value : values) {
+    value = (value_bit_width == 64) ? dist_u64(gen) : (dist_u64(gen) >> (64 - value_bit_width));
+  }
+}
@@ -18,6 +18,7 @@ bench_construction_of_bff_for_kv_map(benchmark::State& state)
 
   generate_random_keys_and_values(keys, values, plaintext_modulo);
 
+  perf_counters_t perf_counters(state);
   for (auto _ : state) {
     benchmark::DoNotOptimize(seed);
     benchmark::DoNotOptimize(keys);
@@ -30,9 +31,18 @@ bench_construction_of_bff_for_kv_map(benchmark::State& state)
     }
   }
 
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * num_keys_in_kv_map));
+
   state.SetItemsProcessed(state.iterations());
 }
 
+BENCHMARK(bench_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/1K Keys")
+  ->Arg(1'000)
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
 BENCHMARK(bench_construction_of_bff_for_kv_map)
   ->Name("bff_for_kv_map/construct/10K Keys")
   ->Arg(10'000)
@@ -40,6 +50,13 @@ BENCHMARK(bench_construction_of_bff_for_kv_map)
   ->ComputeStatistics("min", compute_min)
   ->ComputeStatistics("max", compute_max);
 
+BENCHMARK(bench_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/16K Keys")
+  ->Arg(16'000)
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
 BENCHMARK(bench_construction_of_bff_for_kv_map)
   ->Name("bff_for_kv_map/construct/100K Keys")
   ->Arg(100'000)
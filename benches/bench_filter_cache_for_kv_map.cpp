@@ -0,0 +1,170 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_cache_for_kv_map.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <thread>
+
+constexpr size_t NUM_FILTERS = 1'024;
+constexpr size_t NUM_KEYS_PER_FILTER = 10'000;
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+// Number of keys, per filter, which are kept around for querying it.
+constexpr size_t NUM_QUERIABLE_KEYS_PER_FILTER = 16;
+// Number of queries in each iteration, which pick filters following a Zipf distribution.
+constexpr size_t NUM_QUERIES = 10'000;
+// Simulated latency of fetching a serialized filter from storage, on top of copying and deserializing it.
+constexpr auto LOAD_LATENCY = std::chrono::microseconds(200);
+// Number of background loader threads, and how many queries ahead filters are prefetched.
+constexpr size_t NUM_LOADER_THREADS = 8;
+constexpr size_t PREFETCH_DISTANCE = 64;
+
+// Serialized filters, keys to query them with, and a skewed stream of queries, which are built once and shared by all benchmarks in this file.
+struct serialized_filters_t
+{
+  std::vector<std::vector<uint8_t>> filter_bytes;
+  std::vector<bff_kv_map_utils::bff_key_t> queriable_keys;
+  std::vector<std::pair<uint64_t, size_t>> queries;
+  size_t num_bytes_total = 0;
+};
+
+static const serialized_filters_t&
+get_serialized_filters()
+{
+  static const serialized_filters_t serialized_filters = []() {
+    serialized_filters_t serialized_filters{};
+
+    std::vector<bff_kv_map_utils::bff_key_t> keys(NUM_KEYS_PER_FILTER);
+    std::vector<uint32_t> values(NUM_KEYS_PER_FILTER, 0);
+
+    for (size_t filter_id = 0; filter_id < NUM_FILTERS; filter_id++) {
+      generate_random_keys_and_values(keys, values, PLAINTEXT_MODULO);
+
+      bff_kv_map::bff_for_kv_map_t filter;
+      bool is_constructed = false;
+      while (!is_constructed) {
+        try {
+          filter = bff_kv_map::bff_for_kv_map_t(generate_random_seed(), keys, values, PLAINTEXT_MODULO, LABEL);
+          is_constructed = true;
+        } catch (std::runtime_error& err) {
+        }
+      }
+
+      std::vector<uint8_t> filter_as_bytes(filter.serialized_num_bytes());
+      filter.serialize(filter_as_bytes);
+
+      serialized_filters.num_bytes_total += filter_as_bytes.size();
+      serialized_filters.filter_bytes.push_back(std::move(filter_as_bytes));
+      serialized_filters.queriable_keys.insert(serialized_filters.queriable_keys.end(), keys.begin(), keys.begin() + NUM_QUERIABLE_KEYS_PER_FILTER);
+    }
+
+    // Zipf distribution, with exponent 1, over filter ids.
+    std::vector<double> cdf(NUM_FILTERS, 0.);
+    double sum = 0.;
+    for (size_t filter_id = 0; filter_id < NUM_FILTERS; filter_id++) {
+      sum += 1. / static_cast<double>(filter_id + 1);
+      cdf[filter_id] = sum;
+    }
+
+    std::mt19937_64 gen(NUM_FILTERS);
+    std::uniform_real_distribution<double> dist_cdf(0., sum);
+    std::uniform_int_distribution<size_t> dist_key(0, NUM_QUERIABLE_KEYS_PER_FILTER - 1);
+
+    serialized_filters.queries.resize(NUM_QUERIES);
+    for (auto& [filter_id, key_idx] : serialized_filters.queries) {
+      filter_id = static_cast<uint64_t>(std::min<ptrdiff_t>(std::lower_bound(cdf.begin(), cdf.end(), dist_cdf(gen)) - cdf.begin(), NUM_FILTERS - 1));
+      key_idx = (filter_id * NUM_QUERIABLE_KEYS_PER_FILTER) + dist_key(gen);
+    }
+
+    return serialized_filters;
+  }();
+
+  return serialized_filters;
+}
+
+// Runs a stream of skewed queries against filters fetched through a cache, whose memory budget is a given percentage of all filters, optionally
+// prefetching filters of upcoming queries. Reports hit rate, along with median and tail latency of a query. Loads mostly wait on simulated storage,
+// so throughput is measured in real time.
+static void
+bench_query_through_filter_cache(benchmark::State& state)
+{
+  const auto& serialized_filters = get_serialized_filters();
+  const size_t budget_percent = static_cast<size_t>(state.range(0));
+  const bool is_prefetching = state.range(1) != 0;
+
+  bff_kv_map::bff_for_kv_map_cache_t cache(
+    (serialized_filters.num_bytes_total * budget_percent) / 100,
+    [&](const uint64_t filter_id) {
+      std::this_thread::sleep_for(LOAD_LATENCY);
+      return serialized_filters.filter_bytes[filter_id];
+    },
+    NUM_LOADER_THREADS);
+
+  std::vector<double> query_latencies;
+  query_latencies.reserve(NUM_QUERIES);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    uint64_t sum = 0;
+
+    for (size_t query_idx = 0; query_idx < NUM_QUERIES; query_idx++) {
+      if (is_prefetching && (query_idx + PREFETCH_DISTANCE < NUM_QUERIES)) {
+        cache.prefetch(serialized_filters.queries[query_idx + PREFETCH_DISTANCE].first);
+      }
+
+      const auto [filter_id, key_idx] = serialized_filters.queries[query_idx];
+
+      const auto begin = std::chrono::steady_clock::now();
+      sum += cache.get(filter_id)->recover(serialized_filters.queriable_keys[key_idx]);
+      const auto end = std::chrono::steady_clock::now();
+
+      query_latencies.push_back(std::chrono::duration<double, std::micro>(end - begin).count());
+    }
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * NUM_QUERIES));
+
+  std::sort(query_latencies.begin(), query_latencies.end());
+
+  state.counters["hit_rate"] = static_cast<double>(cache.num_hits()) / static_cast<double>(cache.num_hits() + cache.num_misses());
+  state.counters["p50_us"] = query_latencies[query_latencies.size() / 2];
+  state.counters["p99_us"] = query_latencies[(query_latencies.size() * 99) / 100];
+  state.SetItemsProcessed(state.iterations() * NUM_QUERIES);
+}
+
+BENCHMARK(bench_query_through_filter_cache)
+  ->Name("bff_for_kv_map_cache/query/1K Filters/Zipf/25% Budget/On Demand")
+  ->Args({ 25, 0 })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_query_through_filter_cache)
+  ->Name("bff_for_kv_map_cache/query/1K Filters/Zipf/25% Budget/Prefetched")
+  ->Args({ 25, 1 })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_query_through_filter_cache)
+  ->Name("bff_for_kv_map_cache/query/1K Filters/Zipf/10% Budget/On Demand")
+  ->Args({ 10, 0 })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_query_through_filter_cache)
+  ->Name("bff_for_kv_map_cache/query/1K Filters/Zipf/10% Budget/Prefetched")
+  ->Args({ 10, 1 })
+  ->UseRealTime()
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
@@ -0,0 +1,156 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+constexpr size_t NUM_KEYS_IN_KV_MAP = 10'000'000;
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+
+// A filter over 10M keys, along with its serialized bytes, which are built once and shared by all benchmarks in this file.
+struct filter_with_bytes_t
+{
+  bff_kv_map::bff_for_kv_map_t filter;
+  std::vector<uint8_t> bytes;
+};
+
+static filter_with_bytes_t&
+get_filter_with_bytes()
+{
+  static filter_with_bytes_t filter_with_bytes = []() {
+    filter_with_bytes_t filter_with_bytes{};
+
+    std::vector<bff_kv_map_utils::bff_key_t> keys(NUM_KEYS_IN_KV_MAP);
+    std::vector<uint32_t> values(NUM_KEYS_IN_KV_MAP, 0);
+    generate_random_keys_and_values(keys, values, PLAINTEXT_MODULO);
+
+    bool is_constructed = false;
+    while (!is_constructed) {
+      try {
+        filter_with_bytes.filter = bff_kv_map::bff_for_kv_map_t(generate_random_seed(), keys, values, PLAINTEXT_MODULO, LABEL);
+        is_constructed = true;
+      } catch (std::runtime_error& err) {
+      }
+    }
+
+    filter_with_bytes.bytes = std::vector<uint8_t>(filter_with_bytes.filter.serialized_num_bytes());
+    filter_with_bytes.filter.serialize(filter_with_bytes.bytes);
+
+    return filter_with_bytes;
+  }();
+
+  return filter_with_bytes;
+}
+
+// Hands a filter off to a new owner, by moving it, and back, by move assignment. Neither copies fingerprints, so cost is independent of filter size.
+static void
+bench_move_bff_for_kv_map(benchmark::State& state)
+{
+  auto& filter = get_filter_with_bytes().filter;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    bff_kv_map::bff_for_kv_map_t new_owner(std::move(filter));
+    benchmark::DoNotOptimize(new_owner);
+
+    filter = std::move(new_owner);
+    benchmark::DoNotOptimize(filter);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Swaps a filter with an empty one, and back.
+static void
+bench_swap_bff_for_kv_map(benchmark::State& state)
+{
+  auto& filter = get_filter_with_bytes().filter;
+  bff_kv_map::bff_for_kv_map_t other;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    swap(filter, other);
+    benchmark::DoNotOptimize(other);
+
+    swap(filter, other);
+    benchmark::DoNotOptimize(filter);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+  state.SetItemsProcessed(state.iterations());
+}
+
+// Makes an independent copy of a filter, from its serialized bytes, which is what handing a filter off used to cost, when assignment deep copied its
+// fingerprints.
+static void
+bench_copy_bff_for_kv_map(benchmark::State& state)
+{
+  const auto& bytes = get_filter_with_bytes().bytes;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    bff_kv_map::bff_for_kv_map_t copy(bytes);
+    benchmark::DoNotOptimize(copy);
+    benchmark::ClobberMemory();
+
+    state.PauseTiming();
+    perf_counters.pause();
+    copy = bff_kv_map::bff_for_kv_map_t();
+    perf_counters.resume();
+    state.ResumeTiming();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+
+// Destroys a filter, which wipes its fingerprints before freeing them.
+static void
+bench_destroy_bff_for_kv_map(benchmark::State& state)
+{
+  const auto& bytes = get_filter_with_bytes().bytes;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    state.PauseTiming();
+    perf_counters.pause();
+    auto filter = std::make_unique<bff_kv_map::bff_for_kv_map_t>(bytes);
+    perf_counters.resume();
+    state.ResumeTiming();
+
+    filter.reset();
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+  state.SetItemsProcessed(state.iterations());
+  state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * bytes.size()));
+}
+
+BENCHMARK(bench_move_bff_for_kv_map)
+  ->Name("bff_for_kv_map/hand_off/10M Keys/Move")
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_swap_bff_for_kv_map)
+  ->Name("bff_for_kv_map/hand_off/10M Keys/Swap")
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_copy_bff_for_kv_map)
+  ->Name("bff_for_kv_map/hand_off/10M Keys/Copy")
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_destroy_bff_for_kv_map)
+  ->Name("bff_for_kv_map/hand_off/10M Keys/Destroy")
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
@@ -0,0 +1,75 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/numa.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+// Speculatively constructs the filter, either with workers spread across all NUMA nodes, each first touching its own scratch space, or with the
+// benchmark thread, and so every worker it spawns, confined to a single node, where all scratch and output memory lands. Both placements are the
+// same, unless built with `NUMA=1`, on a multi-socket machine.
+static void
+bench_numa_construction_of_bff_for_kv_map(benchmark::State& state)
+{
+  constexpr size_t plaintext_modulo = 1024;
+  constexpr size_t label = 256;
+
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+  const auto num_speculative_attempts = static_cast<size_t>(state.range(1));
+  const bool is_numa_aware = state.range(2) != 0;
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint32_t> values(num_keys_in_kv_map, 0);
+
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  const auto numa_nodes = bff_kv_map_utils::numa_nodes_of_current_thread();
+  if (!is_numa_aware) {
+    bff_kv_map_utils::bind_current_thread_to_numa_node(numa_nodes.front());
+  }
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    state.PauseTiming();
+    perf_counters.pause();
+    auto seed = generate_random_seed();
+    perf_counters.resume();
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(seed);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(values);
+
+    try {
+      bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label, num_speculative_attempts);
+      benchmark::ClobberMemory();
+    } catch (std::runtime_error& err) {
+    }
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * num_keys_in_kv_map));
+
+  if (!is_numa_aware) {
+    bff_kv_map_utils::unbind_current_thread_from_numa_node();
+  }
+
+  state.counters["numa_nodes"] = static_cast<double>(is_numa_aware ? numa_nodes.size() : 1);
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(bench_numa_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct_numa_aware/1M Keys/4 Attempts")
+  ->Args({ 1'000'000, 4, 1 })
+  ->Iterations(1)
+  ->Repetitions(10)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_numa_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct_single_node/1M Keys/4 Attempts")
+  ->Args({ 1'000'000, 4, 0 })
+  ->Iterations(1)
+  ->Repetitions(10)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
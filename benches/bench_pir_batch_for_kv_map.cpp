@@ -0,0 +1,128 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/pir_batch_for_kv_map.hpp"
+#include <array>
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <vector>
+
+constexpr size_t NUM_KEYS_IN_KV_MAP = 1'000'000;
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+// Number of batches of keys, cuckoo assignment is attempted for, to report the fraction of batches, which are answered in one pass.
+constexpr size_t NUM_ASSIGNED_BATCHES = 1'000;
+
+// A filter over 1M keys, along with its fingerprints modulo p, as held by a PIR server, which is built once and shared by all benchmarks in this file.
+struct pir_server_t
+{
+  bff_kv_map::bff_for_kv_map_t filter;
+  std::vector<bff_kv_map_utils::bff_key_t> keys;
+  std::vector<uint32_t> fingerprints_mod_p;
+};
+
+static const pir_server_t&
+get_pir_server()
+{
+  static const pir_server_t pir_server = []() {
+    pir_server_t pir_server{};
+
+    pir_server.keys = std::vector<bff_kv_map_utils::bff_key_t>(NUM_KEYS_IN_KV_MAP);
+    std::vector<uint32_t> values(NUM_KEYS_IN_KV_MAP, 0);
+    generate_random_keys_and_values(pir_server.keys, values, PLAINTEXT_MODULO);
+
+    bool is_constructed = false;
+    while (!is_constructed) {
+      try {
+        pir_server.filter = bff_kv_map::bff_for_kv_map_t(generate_random_seed(), pir_server.keys, values, PLAINTEXT_MODULO, LABEL);
+        is_constructed = true;
+      } catch (std::runtime_error& err) {
+      }
+    }
+
+    pir_server.fingerprints_mod_p = pir_server.filter.get_fingerprints_mod_p();
+    return pir_server;
+  }();
+
+  return pir_server;
+}
+
+// Answers the query of a batch of keys, spread over given number of buckets, in one server pass, reporting time and number of fingerprints processed
+// per key. A batch of one key over one bucket is the single-key path, processing the whole fingerprint array per key. Also reports the fraction of
+// batches, cuckoo assignment succeeds for, which are otherwise split up.
+static void
+bench_answer_pir_batch_for_kv_map(benchmark::State& state)
+{
+  const auto& pir_server = get_pir_server();
+
+  const auto batch_size = static_cast<size_t>(state.range(0));
+  const auto num_buckets = static_cast<size_t>(state.range(1));
+
+  bff_kv_map::bff_for_kv_map_pir_batch_t pir_batch(pir_server.filter, num_buckets);
+
+  std::vector<std::array<uint32_t, 3>> hash_evals(batch_size);
+  std::vector<uint32_t> key_of_bucket(pir_batch.num_buckets());
+  std::vector<uint32_t> batch_query(pir_batch.query_num_elements());
+  std::vector<uint32_t> answers(pir_batch.num_buckets());
+
+  size_t num_assigned_batches = 0;
+  for (size_t batch_idx = 0; batch_idx < NUM_ASSIGNED_BATCHES; batch_idx++) {
+    for (size_t i = 0; i < batch_size; i++) {
+      hash_evals[i] = pir_server.filter.get_hash_evals(pir_server.keys[((batch_idx * batch_size) + i) % pir_server.keys.size()]);
+    }
+
+    num_assigned_batches += pir_batch.assign(hash_evals, key_of_bucket) ? 1 : 0;
+  }
+
+  // Server work doesn't depend on which buckets answer a key, so any assignable batch makes a representative query.
+  for (size_t batch_idx = 0; !pir_batch.assign(hash_evals, key_of_bucket); batch_idx++) {
+    for (size_t i = 0; i < batch_size; i++) {
+      hash_evals[i] = pir_server.filter.get_hash_evals(pir_server.keys[((batch_idx * batch_size) + i) % pir_server.keys.size()]);
+    }
+  }
+  pir_batch.query(hash_evals, key_of_bucket, batch_query);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(batch_query);
+
+    const bool is_answered = pir_batch.answer(pir_server.fingerprints_mod_p, batch_query, answers);
+    benchmark::DoNotOptimize(is_answered);
+    benchmark::DoNotOptimize(answers);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * batch_size));
+
+  state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * batch_size));
+  state.counters["buckets"] = static_cast<double>(pir_batch.num_buckets());
+  state.counters["slots_per_key"] = static_cast<double>(pir_batch.query_num_elements()) / static_cast<double>(batch_size);
+  state.counters["assigned_batches"] = static_cast<double>(num_assigned_batches) / static_cast<double>(NUM_ASSIGNED_BATCHES);
+}
+
+BENCHMARK(bench_answer_pir_batch_for_kv_map)
+  ->Name("bff_for_kv_map/pir_batch/answer/1M Keys/Single Key")
+  ->Args({ 1, 1 })
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_answer_pir_batch_for_kv_map)
+  ->Name("bff_for_kv_map/pir_batch/answer/1M Keys/Batch of 8 Keys")
+  ->Args({ 8, 24 })
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_answer_pir_batch_for_kv_map)
+  ->Name("bff_for_kv_map/pir_batch/answer/1M Keys/Batch of 16 Keys")
+  ->Args({ 16, 48 })
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_answer_pir_batch_for_kv_map)
+  ->Name("bff_for_kv_map/pir_batch/answer/1M Keys/Batch of 32 Keys")
+  ->Args({ 32, 96 })
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
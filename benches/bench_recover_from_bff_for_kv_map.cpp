@@ -32,6 +32,7 @@ bench_recover_from_bff_for_kv_map(benchmark::State& state)
   size_t key_idx = 0;
   uint32_t value = 0;
 
+  perf_counters_t perf_counters(state);
   for (auto _ : state) {
     benchmark::DoNotOptimize(filter);
     benchmark::DoNotOptimize(keys);
@@ -46,7 +47,10 @@ bench_recover_from_bff_for_kv_map(benchmark::State& state)
     key_idx %= keys.size();
   }
 
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
   state.SetItemsProcessed(state.iterations());
+  state.counters["bits_per_key"] = static_cast<double>(filter.serialized_num_bytes() * 8) / static_cast<double>(num_keys_in_kv_map);
 }
 
 BENCHMARK(bench_recover_from_bff_for_kv_map)
@@ -0,0 +1,121 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/recover_view.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <map>
+#include <ranges>
+
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+// Number of keys queried, through a range pipeline, in each iteration.
+constexpr size_t NUM_QUERIED_KEYS = 100'000;
+
+struct filter_with_keys_t
+{
+  std::vector<bff_kv_map_utils::bff_key_t> keys;
+  bff_kv_map::bff_for_kv_map_t filter;
+};
+
+// Filters are built once per number of keys and shared by both ways of recovering, because building large filters dominates runtime.
+static const filter_with_keys_t&
+get_filter(const size_t num_keys_in_kv_map)
+{
+  static std::map<size_t, filter_with_keys_t> filters;
+
+  auto [it, is_inserted] = filters.try_emplace(num_keys_in_kv_map);
+  if (is_inserted) {
+    auto& filter_with_keys = it->second;
+
+    filter_with_keys.keys = std::vector<bff_kv_map_utils::bff_key_t>(num_keys_in_kv_map);
+    std::vector<uint32_t> values(num_keys_in_kv_map, 0);
+    generate_random_keys_and_values(filter_with_keys.keys, values, PLAINTEXT_MODULO);
+
+    bool is_constructed = false;
+    while (!is_constructed) {
+      try {
+        filter_with_keys.filter = bff_kv_map::bff_for_kv_map_t(generate_random_seed(), filter_with_keys.keys, values, PLAINTEXT_MODULO, LABEL);
+        is_constructed = true;
+      } catch (std::runtime_error& err) {
+      }
+    }
+  }
+
+  return it->second;
+}
+
+// Sums up values recovered for queried keys, by transforming each key with `recover` in a range pipeline.
+static void
+bench_recover_via_transform(benchmark::State& state)
+{
+  const auto& [keys, filter] = get_filter(static_cast<size_t>(state.range(0)));
+  const auto queried_keys = std::span(keys).first(NUM_QUERIED_KEYS);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(queried_keys);
+
+    uint64_t sum = 0;
+    for (const uint32_t value : queried_keys | std::views::transform([&](const bff_kv_map_utils::bff_key_t& key) { return filter.recover(key); })) {
+      sum += value;
+    }
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * NUM_QUERIED_KEYS));
+
+  state.SetItemsProcessed(state.iterations() * NUM_QUERIED_KEYS);
+}
+
+// Sums up values recovered for queried keys, by piping keys through `recover_view`, which recovers them in batches.
+static void
+bench_recover_via_recover_view(benchmark::State& state)
+{
+  const auto& [keys, filter] = get_filter(static_cast<size_t>(state.range(0)));
+  const auto queried_keys = std::span(keys).first(NUM_QUERIED_KEYS);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(queried_keys);
+
+    uint64_t sum = 0;
+    for (const uint32_t value : queried_keys | bff_kv_map::views::recover(filter)) {
+      sum += value;
+    }
+
+    benchmark::DoNotOptimize(sum);
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * NUM_QUERIED_KEYS));
+
+  state.SetItemsProcessed(state.iterations() * NUM_QUERIED_KEYS);
+}
+
+BENCHMARK(bench_recover_via_transform)
+  ->Name("bff_for_kv_map/recover_via_transform/1M Keys")
+  ->Arg(1'000'000)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_via_recover_view)
+  ->Name("bff_for_kv_map/recover_via_recover_view/1M Keys")
+  ->Arg(1'000'000)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_via_transform)
+  ->Name("bff_for_kv_map/recover_via_transform/10M Keys")
+  ->Arg(10'000'000)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_via_recover_view)
+  ->Name("bff_for_kv_map/recover_via_recover_view/10M Keys")
+  ->Arg(10'000'000)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
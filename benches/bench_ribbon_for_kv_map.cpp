@@ -0,0 +1,116 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/ribbon_for_kv_map.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+static void
+bench_construction_of_ribbon_for_kv_map(benchmark::State& state)
+{
+  constexpr size_t plaintext_modulo = 1024;
+  constexpr size_t label = 256;
+
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+
+  auto seed = generate_random_seed();
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint32_t> values(num_keys_in_kv_map, 0);
+
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(seed);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(values);
+
+    try {
+      bff_kv_map::ribbon_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+      benchmark::ClobberMemory();
+    } catch (std::runtime_error& err) {
+    }
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * num_keys_in_kv_map));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void
+bench_recover_from_ribbon_for_kv_map(benchmark::State& state)
+{
+  constexpr size_t plaintext_modulo = 1024;
+  constexpr size_t label = 256;
+
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint32_t> values(num_keys_in_kv_map, 0);
+
+  auto seed = generate_random_seed();
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  bff_kv_map::ribbon_for_kv_map_t filter;
+
+  bool is_constructed = false;
+  while (!is_constructed) {
+    try {
+      filter = bff_kv_map::ribbon_for_kv_map_t(seed, keys, values, plaintext_modulo, label);
+      is_constructed = true;
+    } catch (std::runtime_error& err) {
+      seed = generate_random_seed();
+    }
+  }
+
+  size_t key_idx = 0;
+  uint32_t value = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(key_idx);
+    benchmark::DoNotOptimize(value);
+
+    value ^= filter.recover(keys[key_idx]);
+
+    benchmark::ClobberMemory();
+
+    key_idx++;
+    key_idx %= keys.size();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["stash_size"] = static_cast<double>(filter.stash_size());
+  // Space of the stash of bumped keys is reported on its own, while also being counted in the total, which is compared against `bff_for_kv_map_t`.
+  state.counters["stash_bits_per_key"] = static_cast<double>(filter.stash_num_bytes() * 8) / static_cast<double>(num_keys_in_kv_map);
+  state.counters["bits_per_key"] = static_cast<double>(filter.serialized_num_bytes() * 8) / static_cast<double>(num_keys_in_kv_map);
+}
+
+BENCHMARK(bench_construction_of_ribbon_for_kv_map)
+  ->Name("ribbon_for_kv_map/construct/1M Keys")
+  ->Arg(1'000'000)
+  ->Unit(benchmark::TimeUnit::kSecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_construction_of_ribbon_for_kv_map)
+  ->Name("ribbon_for_kv_map/construct/10M Keys")
+  ->Arg(10'000'000)
+  ->Unit(benchmark::TimeUnit::kSecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_ribbon_for_kv_map)
+  ->Name("ribbon_for_kv_map/recover/1M Keys")
+  ->Arg(1'000'000)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_ribbon_for_kv_map)
+  ->Name("ribbon_for_kv_map/recover/10M Keys")
+  ->Arg(10'000'000)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
@@ -0,0 +1,84 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+// Each iteration constructs the filter under a fresh random seed, so that tail of the distribution of construction time, over repetitions,
+// reflects unlucky seeds, which need more than one construction attempt.
+static void
+bench_speculative_construction_of_bff_for_kv_map(benchmark::State& state)
+{
+  constexpr size_t plaintext_modulo = 1024;
+  constexpr size_t label = 256;
+
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+  const auto num_speculative_attempts = static_cast<size_t>(state.range(1));
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint32_t> values(num_keys_in_kv_map, 0);
+
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    state.PauseTiming();
+    perf_counters.pause();
+    auto seed = generate_random_seed();
+    perf_counters.resume();
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(seed);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(values);
+
+    try {
+      bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label, num_speculative_attempts);
+      benchmark::ClobberMemory();
+    } catch (std::runtime_error& err) {
+    }
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * num_keys_in_kv_map));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(bench_speculative_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct_speculatively/1K Keys/1 Attempt")
+  ->Args({ 1'000, 1 })
+  ->Iterations(1)
+  ->Repetitions(1'000)
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max)
+  ->ComputeStatistics("p99", compute_p99);
+
+BENCHMARK(bench_speculative_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct_speculatively/1K Keys/4 Attempts")
+  ->Args({ 1'000, 4 })
+  ->Iterations(1)
+  ->Repetitions(1'000)
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max)
+  ->ComputeStatistics("p99", compute_p99);
+
+BENCHMARK(bench_speculative_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct_speculatively/100K Keys/1 Attempt")
+  ->Args({ 100'000, 1 })
+  ->Iterations(1)
+  ->Repetitions(100)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max)
+  ->ComputeStatistics("p99", compute_p99);
+
+BENCHMARK(bench_speculative_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct_speculatively/100K Keys/4 Attempts")
+  ->Args({ 100'000, 4 })
+  ->Iterations(1)
+  ->Repetitions(100)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max)
+  ->ComputeStatistics("p99", compute_p99);
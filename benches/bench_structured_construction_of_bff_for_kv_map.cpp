@@ -0,0 +1,245 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include <algorithm>
+#include <array>
+#include <benchmark/benchmark.h>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <utility>
+#include <vector>
+
+// Distributions of keys, filters are built over. Real world keys are seldom uniformly random, and structure left in them, after hashing with
+// `mix256`, shows up as extra construction attempts, or as skewed probes.
+enum class key_distribution_t : int64_t
+{
+  // Uniformly random 256 -bit keys, as a baseline.
+  random,
+  // Sequential ids, in the first word, while other words are zero.
+  sequential,
+  // Keys sharing three random words, differing in a random last word.
+  single_word_varying,
+  // Keys in clusters of 4K sequential ids, each cluster under a random three word prefix.
+  clustered,
+  // Keys differing from one random key only in the lowest byte of each word.
+  near_duplicate,
+};
+
+// Number of sequential ids in a cluster of keys, sharing a prefix.
+constexpr size_t CLUSTER_SIZE = 4'096;
+// Number of keys, recover latency is averaged over.
+constexpr size_t NUM_RECOVERED_KEYS = 100'000;
+
+// Generates distinct keys following given distribution, and uniformly random values.
+static void
+generate_structured_keys_and_values(const key_distribution_t distribution,
+                                    std::span<bff_kv_map_utils::bff_key_t> keys,
+                                    std::span<uint32_t> values,
+                                    const uint64_t plaintext_modulo)
+{
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  std::random_device rd;
+  std::mt19937_64 gen(rd());
+  std::uniform_int_distribution<uint64_t> dist_u64;
+
+  const std::array<uint64_t, 4> base_words{ dist_u64(gen), dist_u64(gen), dist_u64(gen), dist_u64(gen) };
+  std::array<uint64_t, 3> prefix_words{};
+
+  for (size_t i = 0; i < keys.size(); i++) {
+    auto& words = keys[i].words;
+
+    switch (distribution) {
+      case key_distribution_t::random:
+        break;
+      case key_distribution_t::sequential:
+        words = { i, 0, 0, 0 };
+        break;
+      case key_distribution_t::single_word_varying:
+        // Random last words are distinct with overwhelming probability.
+        words = { base_words[0], base_words[1], base_words[2], words[3] };
+        break;
+      case key_distribution_t::clustered:
+        if ((i % CLUSTER_SIZE) == 0) {
+          prefix_words = { dist_u64(gen), dist_u64(gen), dist_u64(gen) };
+        }
+
+        words = { prefix_words[0], prefix_words[1], prefix_words[2], i % CLUSTER_SIZE };
+        break;
+      case key_distribution_t::near_duplicate:
+        for (size_t word_idx = 0; word_idx < words.size(); word_idx++) {
+          words[word_idx] = base_words[word_idx] ^ ((i >> (word_idx * 8)) & 0xff);
+        }
+        break;
+    }
+  }
+}
+
+// Returns number of attempts construction took, by finding which attempt's seed the filter ended up with.
+static size_t
+count_construction_attempts(std::span<const uint8_t, 32> seed, const bff_kv_map::bff_for_kv_map_t& filter)
+{
+  const auto filter_seed = filter.get_seed();
+
+  for (size_t attempt = 0; attempt < bff_kv_map::BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT; attempt++) {
+    if (bff_kv_map_utils::derive_seed(seed, attempt) == filter_seed) {
+      return attempt + 1;
+    }
+  }
+
+  return bff_kv_map::BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT;
+}
+
+// Builds filters over keys of given distribution, each time under a fresh seed, reporting mean and max number of construction attempts, along with
+// failed builds. Recover latency of the last filter is reported too, averaged over keys queried in random order.
+static void
+bench_structured_construction_of_bff_for_kv_map(benchmark::State& state)
+{
+  constexpr size_t plaintext_modulo = 1024;
+  constexpr size_t label = 256;
+
+  const auto distribution = static_cast<key_distribution_t>(state.range(0));
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(1));
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint32_t> values(num_keys_in_kv_map, 0);
+
+  generate_structured_keys_and_values(distribution, keys, values, plaintext_modulo);
+
+  bff_kv_map::bff_for_kv_map_t filter;
+
+  size_t num_attempts = 0;
+  size_t max_num_attempts = 0;
+  size_t num_failed_builds = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    state.PauseTiming();
+    perf_counters.pause();
+    const auto seed = generate_random_seed();
+    perf_counters.resume();
+    state.ResumeTiming();
+
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(values);
+
+    try {
+      bff_kv_map::bff_for_kv_map_t built(seed, keys, values, plaintext_modulo, label);
+      benchmark::ClobberMemory();
+
+      // Attempt counting and releasing the previously built filter are not part of construction.
+      state.PauseTiming();
+      perf_counters.pause();
+
+      const auto num_build_attempts = count_construction_attempts(seed, built);
+      num_attempts += num_build_attempts;
+      max_num_attempts = std::max(max_num_attempts, num_build_attempts);
+
+      filter = std::move(built);
+
+      perf_counters.resume();
+      state.ResumeTiming();
+    } catch (std::runtime_error& err) {
+      num_attempts += bff_kv_map::BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT;
+      max_num_attempts = bff_kv_map::BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT;
+      num_failed_builds++;
+    }
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * num_keys_in_kv_map));
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["attempts"] = static_cast<double>(num_attempts) / static_cast<double>(state.iterations());
+  state.counters["max_attempts"] = static_cast<double>(max_num_attempts);
+  state.counters["failed_builds"] = static_cast<double>(num_failed_builds);
+
+  if (num_failed_builds == static_cast<size_t>(state.iterations())) {
+    return;
+  }
+
+  std::vector<bff_kv_map_utils::bff_key_t> recovered_keys(keys.begin(), keys.end());
+  std::shuffle(recovered_keys.begin(), recovered_keys.end(), std::mt19937_64(num_keys_in_kv_map));
+  recovered_keys.resize(std::min(recovered_keys.size(), NUM_RECOVERED_KEYS));
+
+  uint32_t value = 0;
+
+  const auto begin = std::chrono::steady_clock::now();
+  for (const auto& key : recovered_keys) {
+    value ^= filter.recover(key);
+  }
+  const auto end = std::chrono::steady_clock::now();
+
+  benchmark::DoNotOptimize(value);
+  state.counters["recover_ns"] = std::chrono::duration<double, std::nano>(end - begin).count() / static_cast<double>(recovered_keys.size());
+}
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Random Keys/100K Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::random), 100'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Random Keys/1M Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::random), 1'000'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Sequential Keys/100K Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::sequential), 100'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Sequential Keys/1M Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::sequential), 1'000'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Single Word Varying Keys/100K Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::single_word_varying), 100'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Single Word Varying Keys/1M Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::single_word_varying), 1'000'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Clustered Keys/100K Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::clustered), 100'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Clustered Keys/1M Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::clustered), 1'000'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Near Duplicate Keys/100K Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::near_duplicate), 100'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_structured_construction_of_bff_for_kv_map)
+  ->Name("bff_for_kv_map/construct/Near Duplicate Keys/1M Keys")
+  ->Args({ static_cast<int64_t>(key_distribution_t::near_duplicate), 1'000'000 })
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
@@ -0,0 +1,178 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/sub_filter_for_kv_map.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+constexpr size_t NUM_KEYS_IN_KV_MAP = 10'000'000;
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+
+// Full filter over 10M keys, which is built once and shared by all benchmarks in this file, because building it dominates their runtime.
+struct full_filter_t
+{
+  std::vector<bff_kv_map_utils::bff_key_t> keys;
+  std::vector<uint32_t> values;
+  bff_kv_map::bff_for_kv_map_t filter;
+  std::vector<uint8_t> filter_as_bytes;
+};
+
+static const full_filter_t&
+get_full_filter()
+{
+  static const full_filter_t full_filter = []() {
+    full_filter_t full_filter{};
+
+    full_filter.keys = std::vector<bff_kv_map_utils::bff_key_t>(NUM_KEYS_IN_KV_MAP);
+    full_filter.values = std::vector<uint32_t>(NUM_KEYS_IN_KV_MAP, 0);
+    generate_random_keys_and_values(full_filter.keys, full_filter.values, PLAINTEXT_MODULO);
+
+    bool is_constructed = false;
+    while (!is_constructed) {
+      try {
+        full_filter.filter = bff_kv_map::bff_for_kv_map_t(generate_random_seed(), full_filter.keys, full_filter.values, PLAINTEXT_MODULO, LABEL);
+        is_constructed = true;
+      } catch (std::runtime_error& err) {
+      }
+    }
+
+    full_filter.filter_as_bytes = std::vector<uint8_t>(full_filter.filter.serialized_num_bytes());
+    full_filter.filter.serialize(full_filter.filter_as_bytes);
+
+    return full_filter;
+  }();
+
+  return full_filter;
+}
+
+static void
+bench_extract_sub_filter(benchmark::State& state)
+{
+  const auto& full_filter = get_full_filter();
+  const auto sub_keys = std::span(full_filter.keys).first(static_cast<size_t>(state.range(0)));
+
+  size_t sub_filter_num_bytes = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sub_keys);
+
+    const auto sub_filter_as_bytes = full_filter.filter.extract_sub_filter(sub_keys);
+    sub_filter_num_bytes = sub_filter_as_bytes.size();
+
+    benchmark::DoNotOptimize(sub_filter_as_bytes);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * sub_keys.size()));
+
+  state.SetItemsProcessed(state.iterations());
+  state.counters["sub_filter_bytes"] = static_cast<double>(sub_filter_num_bytes);
+  state.counters["full_filter_bytes"] = static_cast<double>(full_filter.filter_as_bytes.size());
+}
+
+static void
+bench_load_sub_filter(benchmark::State& state)
+{
+  const auto& full_filter = get_full_filter();
+  const auto sub_keys = std::span(full_filter.keys).first(static_cast<size_t>(state.range(0)));
+  const auto sub_filter_as_bytes = full_filter.filter.extract_sub_filter(sub_keys);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sub_filter_as_bytes);
+
+    bff_kv_map::bff_for_kv_map_sub_filter_view_t sub_filter(sub_filter_as_bytes);
+
+    benchmark::DoNotOptimize(sub_filter);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void
+bench_load_full_filter(benchmark::State& state)
+{
+  const auto& full_filter = get_full_filter();
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(full_filter.filter_as_bytes);
+
+    bff_kv_map::bff_for_kv_map_t filter(full_filter.filter_as_bytes);
+
+    benchmark::DoNotOptimize(filter);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void
+bench_recover_from_sub_filter(benchmark::State& state)
+{
+  const auto& full_filter = get_full_filter();
+  const auto sub_keys = std::span(full_filter.keys).first(static_cast<size_t>(state.range(0)));
+  const auto sub_filter_as_bytes = full_filter.filter.extract_sub_filter(sub_keys);
+
+  bff_kv_map::bff_for_kv_map_sub_filter_view_t sub_filter(sub_filter_as_bytes);
+
+  size_t key_idx = 0;
+  uint32_t value = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(sub_filter);
+    benchmark::DoNotOptimize(key_idx);
+    benchmark::DoNotOptimize(value);
+
+    value ^= sub_filter.recover(sub_keys[key_idx]).value_or(0);
+
+    benchmark::ClobberMemory();
+
+    key_idx++;
+    key_idx %= sub_keys.size();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(bench_extract_sub_filter)
+  ->Name("bff_for_kv_map/extract_sub_filter/10M Keys/1K Sub Keys")
+  ->Arg(1'000)
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_extract_sub_filter)
+  ->Name("bff_for_kv_map/extract_sub_filter/10M Keys/100K Sub Keys")
+  ->Arg(100'000)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_load_sub_filter)
+  ->Name("bff_for_kv_map_sub_filter_view/load/10M Keys/1K Sub Keys")
+  ->Arg(1'000)
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_load_full_filter)
+  ->Name("bff_for_kv_map/load/10M Keys")
+  ->Unit(benchmark::TimeUnit::kMicrosecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_sub_filter)
+  ->Name("bff_for_kv_map_sub_filter_view/recover/10M Keys/1K Sub Keys")
+  ->Arg(1'000)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
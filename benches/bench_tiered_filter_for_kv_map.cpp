@@ -0,0 +1,274 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/tiered_filter_for_kv_map.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <fcntl.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+
+constexpr size_t NUM_KEYS_IN_KV_MAP = 10'000'000;
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 256;
+// Each iteration queries these many keys, where 90% of queries hit a small set of hot keys.
+constexpr size_t NUM_QUERIED_KEYS = 100'000;
+constexpr size_t NUM_HOT_KEYS = 1'000;
+// Budget of hot tier, enough for every block probed by hot keys.
+constexpr size_t MAX_HOT_NUM_BYTES = 16UL << 20;
+// Memory, beyond the hot tier budget, which the benchmark may use under memory pressure, leaving only a fraction of the ~45MB filter file resident.
+constexpr size_t MAX_COLD_NUM_BYTES = 8UL << 20;
+
+// Filter over 10M keys, along with its serialized file and a skewed set of queried keys, which is built once and shared by all benchmarks in this file.
+struct filter_with_file_t
+{
+  std::vector<bff_kv_map_utils::bff_key_t> queried_keys;
+  bff_kv_map::bff_for_kv_map_t filter;
+  std::string file_path;
+};
+
+static const filter_with_file_t&
+get_filter_with_file()
+{
+  static const filter_with_file_t filter_with_file = []() {
+    filter_with_file_t filter_with_file{};
+
+    std::vector<bff_kv_map_utils::bff_key_t> keys(NUM_KEYS_IN_KV_MAP);
+    std::vector<uint32_t> values(NUM_KEYS_IN_KV_MAP, 0);
+    generate_random_keys_and_values(keys, values, PLAINTEXT_MODULO);
+
+    bool is_constructed = false;
+    while (!is_constructed) {
+      try {
+        filter_with_file.filter = bff_kv_map::bff_for_kv_map_t(generate_random_seed(), keys, values, PLAINTEXT_MODULO, LABEL);
+        is_constructed = true;
+      } catch (std::runtime_error& err) {
+      }
+    }
+
+    std::vector<uint8_t> filter_as_bytes(filter_with_file.filter.serialized_num_bytes());
+    filter_with_file.filter.serialize(filter_as_bytes);
+
+    filter_with_file.file_path = (std::filesystem::temp_directory_path() / "bench_tiered_filter_for_kv_map.bin").string();
+    std::ofstream file(filter_with_file.file_path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(filter_as_bytes.data()), static_cast<std::streamsize>(filter_as_bytes.size()));
+
+    std::mt19937_64 gen(NUM_KEYS_IN_KV_MAP);
+    std::uniform_int_distribution<size_t> dist_percent(0, 99);
+    std::uniform_int_distribution<size_t> dist_hot_key(0, NUM_HOT_KEYS - 1);
+    std::uniform_int_distribution<size_t> dist_key(0, NUM_KEYS_IN_KV_MAP - 1);
+
+    filter_with_file.queried_keys.resize(NUM_QUERIED_KEYS);
+    for (auto& queried_key : filter_with_file.queried_keys) {
+      queried_key = keys[(dist_percent(gen) < 90) ? dist_hot_key(gen) : dist_key(gen)];
+    }
+
+    return filter_with_file;
+  }();
+
+  return filter_with_file;
+}
+
+// Memory cgroup, which the benchmark process is moved into while it's alive, so that page cache of the filter file is evicted under its memory limit,
+// as it would be on a host with less memory than the file. It's created under the cgroup v1 memory controller, or cgroup v2 with the memory
+// controller enabled, which usually requires root. `is_joined` tells whether the process got moved into it.
+struct memory_cgroup_t
+{
+  std::filesystem::path parent_path;
+  std::filesystem::path path;
+  bool is_joined = false;
+
+  explicit memory_cgroup_t(const size_t limit_num_bytes)
+  {
+    std::ifstream controllers("/sys/fs/cgroup/cgroup.controllers");
+    std::string controller;
+    bool is_v2 = false;
+    while (controllers >> controller) {
+      is_v2 |= controller == "memory";
+    }
+
+    std::ifstream self_cgroup("/proc/self/cgroup");
+    for (std::string line; std::getline(self_cgroup, line);) {
+      if (is_v2 && line.starts_with("0::")) {
+        parent_path = "/sys/fs/cgroup" + line.substr(3);
+      } else if (!is_v2 && (line.find(":memory:") != std::string::npos)) {
+        parent_path = "/sys/fs/cgroup/memory" + line.substr(line.find(":memory:") + 8);
+      }
+    }
+
+    std::error_code err;
+    path = parent_path / ("bench_tiered_filter_for_kv_map." + std::to_string(getpid()));
+    if (parent_path.empty() || !std::filesystem::create_directory(path, err)) {
+      path.clear();
+      return;
+    }
+
+    is_joined = write_to(path / (is_v2 ? "memory.max" : "memory.limit_in_bytes"), limit_num_bytes) && write_to(path / "cgroup.procs", getpid());
+  }
+
+  memory_cgroup_t(const memory_cgroup_t&) = delete;
+  memory_cgroup_t& operator=(const memory_cgroup_t&) = delete;
+
+  ~memory_cgroup_t()
+  {
+    if (is_joined) {
+      write_to(parent_path / "cgroup.procs", getpid());
+    }
+    if (!path.empty()) {
+      rmdir(path.c_str());
+    }
+  }
+
+private:
+  template<typename T>
+  static bool write_to(const std::filesystem::path& file_path, const T value)
+  {
+    std::ofstream file(file_path);
+    file << value << std::flush;
+    return file.good();
+  }
+};
+
+// Drops pages of given file from page cache, so that they are faulted in afresh, and charged to the memory cgroup of whoever touches them next.
+static void
+drop_from_page_cache(const std::string& file_path)
+{
+  const int fd = open(file_path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    fdatasync(fd);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+    close(fd);
+  }
+}
+
+// Recovers values for skewed queries, from the in-memory filter.
+static void
+bench_recover_batch_from_in_memory_filter(benchmark::State& state)
+{
+  const auto& filter_with_file = get_filter_with_file();
+  std::vector<uint32_t> values(NUM_QUERIED_KEYS, 0);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter_with_file.queried_keys);
+
+    filter_with_file.filter.recover_batch(filter_with_file.queried_keys, values);
+
+    benchmark::DoNotOptimize(values);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * NUM_QUERIED_KEYS));
+
+  state.SetItemsProcessed(state.iterations() * NUM_QUERIED_KEYS);
+}
+
+// Recovers values for skewed queries, from the tiered filter, either with every block in cold tier, or after rebalancing hot blocks into hot tier.
+static void
+bench_recover_batch_from_tiered_filter(benchmark::State& state)
+{
+  const auto& filter_with_file = get_filter_with_file();
+  const bool is_rebalanced = state.range(0) != 0;
+
+  bff_kv_map::bff_for_kv_map_tiered_t tiered_filter(filter_with_file.file_path);
+  std::vector<uint32_t> values(NUM_QUERIED_KEYS, 0);
+
+  if (is_rebalanced) {
+    tiered_filter.recover_batch(filter_with_file.queried_keys, values);
+    tiered_filter.rebalance(MAX_HOT_NUM_BYTES);
+  }
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter_with_file.queried_keys);
+
+    tiered_filter.recover_batch(filter_with_file.queried_keys, values);
+
+    benchmark::DoNotOptimize(values);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * NUM_QUERIED_KEYS));
+
+  state.counters["hot_blocks"] = static_cast<double>(tiered_filter.num_hot_blocks());
+  state.counters["is_hot_tier_pinned"] = tiered_filter.is_hot_tier_pinned() ? 1 : 0;
+  state.SetItemsProcessed(state.iterations() * NUM_QUERIED_KEYS);
+}
+
+// Recovers values for skewed queries, from the tiered filter, while the benchmark is confined to a memory cgroup, which fits the hot tier budget and
+// only a fraction of the file, so that cold pages keep getting evicted. Both with every block in cold tier, and after rebalancing hot blocks into
+// hot tier, memory limit is the same. Skipped, if a memory cgroup can't be created.
+static void
+bench_recover_batch_from_tiered_filter_under_memory_pressure(benchmark::State& state)
+{
+  const auto& filter_with_file = get_filter_with_file();
+  const bool is_rebalanced = state.range(0) != 0;
+
+  drop_from_page_cache(filter_with_file.file_path);
+
+  memory_cgroup_t memory_cgroup(MAX_HOT_NUM_BYTES + MAX_COLD_NUM_BYTES);
+  if (!memory_cgroup.is_joined) {
+    state.SkipWithError("Failed to create a memory cgroup, which requires root.");
+    return;
+  }
+
+  bff_kv_map::bff_for_kv_map_tiered_t tiered_filter(filter_with_file.file_path);
+  std::vector<uint32_t> values(NUM_QUERIED_KEYS, 0);
+
+  if (is_rebalanced) {
+    tiered_filter.recover_batch(filter_with_file.queried_keys, values);
+    tiered_filter.rebalance(MAX_HOT_NUM_BYTES);
+  }
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter_with_file.queried_keys);
+
+    tiered_filter.recover_batch(filter_with_file.queried_keys, values);
+
+    benchmark::DoNotOptimize(values);
+    benchmark::ClobberMemory();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * NUM_QUERIED_KEYS));
+
+  state.counters["hot_blocks"] = static_cast<double>(tiered_filter.num_hot_blocks());
+  state.counters["is_hot_tier_pinned"] = tiered_filter.is_hot_tier_pinned() ? 1 : 0;
+  state.SetItemsProcessed(state.iterations() * NUM_QUERIED_KEYS);
+}
+
+BENCHMARK(bench_recover_batch_from_in_memory_filter)
+  ->Name("bff_for_kv_map/recover_batch/10M Keys/90% Hot Queries")
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_batch_from_tiered_filter)
+  ->Name("bff_for_kv_map_tiered/recover_batch/10M Keys/90% Hot Queries/All Cold")
+  ->Arg(0)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_batch_from_tiered_filter)
+  ->Name("bff_for_kv_map_tiered/recover_batch/10M Keys/90% Hot Queries/Rebalanced")
+  ->Arg(1)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_batch_from_tiered_filter_under_memory_pressure)
+  ->Name("bff_for_kv_map_tiered/recover_batch/10M Keys/90% Hot Queries/All Cold/24MB Memory Limit")
+  ->Arg(0)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_batch_from_tiered_filter_under_memory_pressure)
+  ->Name("bff_for_kv_map_tiered/recover_batch/10M Keys/90% Hot Queries/Rebalanced/24MB Memory Limit")
+  ->Arg(1)
+  ->Unit(benchmark::TimeUnit::kMillisecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
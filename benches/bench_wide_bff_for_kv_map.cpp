@@ -0,0 +1,228 @@
+#include "bench_common.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/wide_filter_for_kv_map.hpp"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+
+// 48 -bit values, split into three 16 -bit limbs, either side by side in a single wide filter, or across three separate filters.
+constexpr uint64_t PLAINTEXT_MODULO = 1UL << 16;
+constexpr uint32_t VALUE_BIT_WIDTH = 48;
+constexpr size_t NUM_LIMBS = 3;
+constexpr uint64_t LABEL = 256;
+
+// Splits wide values into limbs, one vector per limb, as one would do by hand, for storing them across separate filters.
+static std::array<std::vector<uint32_t>, NUM_LIMBS>
+split_into_limbs(std::span<const uint64_t> values)
+{
+  std::array<std::vector<uint32_t>, NUM_LIMBS> limbs;
+
+  for (size_t limb_idx = 0; limb_idx < NUM_LIMBS; limb_idx++) {
+    limbs[limb_idx] = std::vector<uint32_t>(values.size(), 0);
+
+    for (size_t i = 0; i < values.size(); i++) {
+      limbs[limb_idx][i] = static_cast<uint32_t>((values[i] >> (16 * limb_idx)) % PLAINTEXT_MODULO);
+    }
+  }
+
+  return limbs;
+}
+
+static void
+bench_construction_of_wide_bff_for_kv_map(benchmark::State& state)
+{
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+
+  auto seed = generate_random_seed();
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint64_t> values(num_keys_in_kv_map, 0);
+
+  generate_random_keys_and_wide_values(keys, values, VALUE_BIT_WIDTH);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(seed);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(values);
+
+    try {
+      bff_kv_map::bff_for_kv_map_wide_t filter(seed, keys, values, PLAINTEXT_MODULO, LABEL, VALUE_BIT_WIDTH);
+      benchmark::ClobberMemory();
+    } catch (std::runtime_error& err) {
+    }
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * num_keys_in_kv_map));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void
+bench_construction_of_multiple_bff_for_kv_maps(benchmark::State& state)
+{
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+
+  auto seed = generate_random_seed();
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint64_t> values(num_keys_in_kv_map, 0);
+
+  generate_random_keys_and_wide_values(keys, values, VALUE_BIT_WIDTH);
+  const auto limbs = split_into_limbs(values);
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(seed);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(limbs);
+
+    try {
+      for (size_t limb_idx = 0; limb_idx < NUM_LIMBS; limb_idx++) {
+        bff_kv_map::bff_for_kv_map_t filter(seed, keys, limbs[limb_idx], PLAINTEXT_MODULO, LABEL);
+        benchmark::ClobberMemory();
+      }
+    } catch (std::runtime_error& err) {
+    }
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations() * num_keys_in_kv_map));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void
+bench_recover_from_wide_bff_for_kv_map(benchmark::State& state)
+{
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint64_t> values(num_keys_in_kv_map, 0);
+
+  auto seed = generate_random_seed();
+  generate_random_keys_and_wide_values(keys, values, VALUE_BIT_WIDTH);
+
+  bff_kv_map::bff_for_kv_map_wide_t filter;
+
+  bool is_constructed = false;
+  while (!is_constructed) {
+    try {
+      filter = bff_kv_map::bff_for_kv_map_wide_t(seed, keys, values, PLAINTEXT_MODULO, LABEL, VALUE_BIT_WIDTH);
+      is_constructed = true;
+    } catch (std::runtime_error& err) {
+      seed = generate_random_seed();
+    }
+  }
+
+  size_t key_idx = 0;
+  uint64_t value = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filter);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(key_idx);
+    benchmark::DoNotOptimize(value);
+
+    value ^= filter.recover64(keys[key_idx]);
+
+    benchmark::ClobberMemory();
+
+    key_idx++;
+    key_idx %= keys.size();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+static void
+bench_recover_from_multiple_bff_for_kv_maps(benchmark::State& state)
+{
+  const auto num_keys_in_kv_map = static_cast<size_t>(state.range(0));
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys_in_kv_map);
+  std::vector<uint64_t> values(num_keys_in_kv_map, 0);
+
+  auto seed = generate_random_seed();
+  generate_random_keys_and_wide_values(keys, values, VALUE_BIT_WIDTH);
+  const auto limbs = split_into_limbs(values);
+
+  std::array<bff_kv_map::bff_for_kv_map_t, NUM_LIMBS> filters;
+
+  for (size_t limb_idx = 0; limb_idx < NUM_LIMBS; limb_idx++) {
+    bool is_constructed = false;
+    while (!is_constructed) {
+      try {
+        filters[limb_idx] = bff_kv_map::bff_for_kv_map_t(seed, keys, limbs[limb_idx], PLAINTEXT_MODULO, LABEL);
+        is_constructed = true;
+      } catch (std::runtime_error& err) {
+        seed = generate_random_seed();
+      }
+    }
+  }
+
+  size_t key_idx = 0;
+  uint64_t value = 0;
+
+  perf_counters_t perf_counters(state);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(filters);
+    benchmark::DoNotOptimize(keys);
+    benchmark::DoNotOptimize(key_idx);
+    benchmark::DoNotOptimize(value);
+
+    uint64_t recovered = 0;
+    for (size_t limb_idx = 0; limb_idx < NUM_LIMBS; limb_idx++) {
+      recovered |= static_cast<uint64_t>(filters[limb_idx].recover(keys[key_idx])) << (16 * limb_idx);
+    }
+    value ^= recovered;
+
+    benchmark::ClobberMemory();
+
+    key_idx++;
+    key_idx %= keys.size();
+  }
+
+  perf_counters.report_per_item(static_cast<double>(state.iterations()));
+
+  state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(bench_construction_of_wide_bff_for_kv_map)
+  ->Name("bff_for_kv_map_wide/construct/1M Keys/48 -bit Values")
+  ->Arg(1'000'000)
+  ->Unit(benchmark::TimeUnit::kSecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_construction_of_multiple_bff_for_kv_maps)
+  ->Name("bff_for_kv_map_x3/construct/1M Keys/48 -bit Values")
+  ->Arg(1'000'000)
+  ->Unit(benchmark::TimeUnit::kSecond)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_wide_bff_for_kv_map)
+  ->Name("bff_for_kv_map_wide/recover/1M Keys/48 -bit Values")
+  ->Arg(1'000'000)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_multiple_bff_for_kv_maps)
+  ->Name("bff_for_kv_map_x3/recover/1M Keys/48 -bit Values")
+  ->Arg(1'000'000)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_wide_bff_for_kv_map)
+  ->Name("bff_for_kv_map_wide/recover/10M Keys/48 -bit Values")
+  ->Arg(10'000'000)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
+
+BENCHMARK(bench_recover_from_multiple_bff_for_kv_maps)
+  ->Name("bff_for_kv_map_x3/recover/10M Keys/48 -bit Values")
+  ->Arg(10'000'000)
+  ->ComputeStatistics("min", compute_min)
+  ->ComputeStatistics("max", compute_max);
@@ -0,0 +1,25 @@
+#include "binary_fuse_filter/autotune.hpp"
+#include "binary_fuse_filter/tuning.hpp"
+#include <iostream>
+#include <string>
+
+// Offline tool, picking tuning parameters for this host and writing them to a tuning file, which is loaded by pointing
+// `BFF_FOR_KV_MAP_TUNING_FILE` to it, or by calling `bff_kv_map::load_tuning`.
+int
+main(int argc, char** argv)
+{
+  const std::string file_path = (argc > 1) ? argv[1] : "bff_for_kv_map.tuning";
+
+  const auto tuning = bff_kv_map::autotune();
+
+  std::cout << "Recover batch size: " << tuning.recover_batch_size << "\n";
+  std::cout << "Construction prefetch distance: " << tuning.construction_prefetch_distance << "\n";
+
+  if (!bff_kv_map::save_tuning(file_path, tuning)) {
+    std::cerr << "Failed to write tuning file " << file_path << "\n";
+    return 1;
+  }
+
+  std::cout << "Written to " << file_path << "\n";
+  return 0;
+}
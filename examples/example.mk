@@ -3,13 +3,18 @@ EXAMPLE_BUILD_DIR := $(BUILD_DIR)/example
 EXAMPLE_DIR := examples
 EXAMPLE_SOURCES := $(wildcard $(EXAMPLE_DIR)/*.cpp)
 EXAMPLE_HEADERS := $(wildcard $(EXAMPLE_DIR)/*.hpp)
-EXAMPLE_EXECS := $(addprefix $(EXAMPLE_BUILD_DIR)/, $(notdir $(EXAMPLE_SOURCES:.cpp=.exe)))
+# Autotuning tool takes minutes, so it's run by its own target, instead of along with examples.
+AUTOTUNE_EXEC := $(EXAMPLE_BUILD_DIR)/autotune.exe
+EXAMPLE_EXECS := $(filter-out $(AUTOTUNE_EXEC), $(addprefix $(EXAMPLE_BUILD_DIR)/, $(notdir $(EXAMPLE_SOURCES:.cpp=.exe))))
 
 $(EXAMPLE_BUILD_DIR):
 	mkdir -p $@
 
 $(EXAMPLE_BUILD_DIR)/%.exe: $(EXAMPLE_DIR)/%.cpp $(EXAMPLE_BUILD_DIR)
-	$(CXX) $(CXX_DEFS) $(CXX_FLAGS) $(WARN_FLAGS) $(RELEASE_FLAGS) $(I_FLAGS) $(DEP_IFLAGS) $< -o $@
+	$(CXX) $(CXX_DEFS) $(CXX_FLAGS) $(WARN_FLAGS) $(RELEASE_FLAGS) $(I_FLAGS) $(DEP_IFLAGS) $< $(NUMA_LINK_FLAGS) -o $@
 
 example: $(EXAMPLE_EXECS) ## Build and run example program, demonstrating usage of BFF-for-KV-Map API
 	$(foreach exec,$^,./$(exec))
+
+autotune: $(AUTOTUNE_EXEC) ## Pick batch size and prefetch distance for this host, writing them to bff_for_kv_map.tuning
+	./$<
@@ -0,0 +1,154 @@
+#pragma once
+#include "filter_for_kv_map.hpp"
+#include "tuning.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <unistd.h>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Candidate values of tuning parameters, which `autotune` picks from.
+constexpr std::array<uint32_t, 6> BFF_FOR_KV_MAP_AUTOTUNE_RECOVER_BATCH_SIZES{ 4, 8, 16, 32, 64, 128 };
+constexpr std::array<uint32_t, 5> BFF_FOR_KV_MAP_AUTOTUNE_CONSTRUCTION_PREFETCH_DISTANCES{ 0, 4, 8, 16, 32 };
+// Number of keys recovered, each time a candidate batch size is timed.
+constexpr size_t BFF_FOR_KV_MAP_AUTOTUNE_NUM_RECOVERED_KEYS = 1UL << 20;
+// Each candidate is timed these many times, in rounds over all candidates, and its fastest run is compared, so that noise and drift are filtered out.
+constexpr size_t BFF_FOR_KV_MAP_AUTOTUNE_NUM_ROUNDS = 3;
+// By default, fingerprints of the filter `recover_batch` is timed against span these many times the last level cache.
+constexpr size_t BFF_FOR_KV_MAP_AUTOTUNE_LLC_MULTIPLE = 4;
+// Last level cache size assumed, when the host doesn't report it.
+constexpr size_t BFF_FOR_KV_MAP_AUTOTUNE_DEFAULT_LLC_NUM_BYTES = 32UL << 20;
+// Upper bound on the default number of keys of the filter `recover_batch` is timed against, so that its construction, which takes well over a hundred
+// bytes per key, still fits in memory of hosts reporting a very large last level cache, e.g. virtual machines reporting the cache of a whole socket.
+constexpr size_t BFF_FOR_KV_MAP_AUTOTUNE_MAX_DEFAULT_RECOVER_KEYS = 1UL << 25;
+
+// Returns size of the last level cache, as reported by the host, or `BFF_FOR_KV_MAP_AUTOTUNE_DEFAULT_LLC_NUM_BYTES`, if it isn't.
+static inline size_t
+last_level_cache_num_bytes()
+{
+#if defined(_SC_LEVEL3_CACHE_SIZE) && defined(_SC_LEVEL2_CACHE_SIZE)
+  for (const int name : { _SC_LEVEL3_CACHE_SIZE, _SC_LEVEL2_CACHE_SIZE }) {
+    if (const long num_bytes = sysconf(name); num_bytes > 0) {
+      return static_cast<size_t>(num_bytes);
+    }
+  }
+#endif
+
+  return BFF_FOR_KV_MAP_AUTOTUNE_DEFAULT_LLC_NUM_BYTES;
+}
+
+// Restores tuning parameters, which were in effect when it got constructed, when it goes out of scope, including by an exception.
+struct tuning_restorer_t
+{
+  const tuning_t tuning_in_effect = get_tuning();
+
+  tuning_restorer_t() = default;
+  tuning_restorer_t(const tuning_restorer_t&) = delete;
+  tuning_restorer_t& operator=(const tuning_restorer_t&) = delete;
+
+  ~tuning_restorer_t() { set_tuning(tuning_in_effect); }
+};
+
+/**
+ * @brief Pick tuning parameters for this host, by micro-benchmarking candidate values against synthetic filters. It takes minutes, so it's meant to run
+ * once per host, from an offline tool, with the result persisted using `save_tuning`, and loaded with `load_tuning` or through
+ * `BFF_FOR_KV_MAP_TUNING_FILE`. Tuning in effect is changed while measuring, and restored before returning, or throwing, so it shouldn't run concurrently
+ * with latency sensitive work.
+ *
+ * @param num_recover_keys Number of keys of the filter `recover_batch` is timed against, s.t. its fingerprints are much larger than last level cache.
+ * If 0, fingerprints are sized to `BFF_FOR_KV_MAP_AUTOTUNE_LLC_MULTIPLE` times the last level cache, with at most
+ * `BFF_FOR_KV_MAP_AUTOTUNE_MAX_DEFAULT_RECOVER_KEYS` keys.
+ * @param num_construction_keys Number of keys of the filter whose construction is timed.
+ * @return The fastest tuning parameters.
+ */
+static inline tuning_t
+autotune(size_t num_recover_keys = 0, const size_t num_construction_keys = 1UL << 20)
+{
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  if (num_recover_keys == 0) {
+    const size_t num_fingerprints = (BFF_FOR_KV_MAP_AUTOTUNE_LLC_MULTIPLE * last_level_cache_num_bytes()) / sizeof(uint32_t);
+    num_recover_keys = std::min(num_fingerprints, BFF_FOR_KV_MAP_AUTOTUNE_MAX_DEFAULT_RECOVER_KEYS);
+  }
+
+  const tuning_restorer_t tuning_restorer;
+  const auto& tuning_in_effect = tuning_restorer.tuning_in_effect;
+
+  std::mt19937_64 gen(num_recover_keys ^ num_construction_keys);
+  std::uniform_int_distribution<uint64_t> dist_u64;
+
+  const auto generate_keys_and_values = [&](const size_t num_keys) {
+    std::vector<bff_kv_map_utils::bff_key_t> keys(num_keys);
+    std::vector<uint32_t> values(num_keys, 0);
+
+    for (size_t i = 0; i < num_keys; i++) {
+      keys[i].words = { dist_u64(gen), dist_u64(gen), dist_u64(gen), dist_u64(gen) };
+      values[i] = static_cast<uint32_t>(dist_u64(gen) % plaintext_modulo);
+    }
+
+    return std::make_pair(std::move(keys), std::move(values));
+  };
+
+  // Returns index of the candidate, which ran fastest, when timed in rounds.
+  const auto pick_fastest = [](const size_t num_candidates, const auto& run_candidate) {
+    std::vector<double> fastest_runs(num_candidates, std::numeric_limits<double>::max());
+
+    for (size_t round = 0; round < BFF_FOR_KV_MAP_AUTOTUNE_NUM_ROUNDS; round++) {
+      for (size_t candidate_idx = 0; candidate_idx < num_candidates; candidate_idx++) {
+        const auto begin = std::chrono::steady_clock::now();
+        run_candidate(candidate_idx);
+        const auto end = std::chrono::steady_clock::now();
+
+        fastest_runs[candidate_idx] = std::min(fastest_runs[candidate_idx], std::chrono::duration<double>(end - begin).count());
+      }
+    }
+
+    return static_cast<size_t>(std::min_element(fastest_runs.begin(), fastest_runs.end()) - fastest_runs.begin());
+  };
+
+  std::array<uint8_t, 32> seed{};
+  std::generate(seed.begin(), seed.end(), [&]() { return static_cast<uint8_t>(dist_u64(gen)); });
+
+  tuning_t tuning = tuning_in_effect;
+
+  {
+    auto [keys, values] = generate_keys_and_values(num_recover_keys);
+    const bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+    // A subset of keys is queried in random order, so that consecutive queries don't share cache lines.
+    std::shuffle(keys.begin(), keys.end(), gen);
+    const auto queried_keys = std::span(keys).first(std::min(keys.size(), BFF_FOR_KV_MAP_AUTOTUNE_NUM_RECOVERED_KEYS));
+    std::vector<uint32_t> recovered_values(queried_keys.size(), 0);
+
+    const size_t fastest_idx = pick_fastest(BFF_FOR_KV_MAP_AUTOTUNE_RECOVER_BATCH_SIZES.size(), [&](const size_t idx) {
+      set_tuning({ BFF_FOR_KV_MAP_AUTOTUNE_RECOVER_BATCH_SIZES[idx], tuning_in_effect.construction_prefetch_distance });
+      filter.recover_batch(queried_keys, recovered_values);
+    });
+
+    tuning.recover_batch_size = BFF_FOR_KV_MAP_AUTOTUNE_RECOVER_BATCH_SIZES[fastest_idx];
+  }
+
+  {
+    const auto keys_and_values = generate_keys_and_values(num_construction_keys);
+
+    const size_t fastest_idx = pick_fastest(BFF_FOR_KV_MAP_AUTOTUNE_CONSTRUCTION_PREFETCH_DISTANCES.size(), [&](const size_t idx) {
+      set_tuning({ tuning_in_effect.recover_batch_size, BFF_FOR_KV_MAP_AUTOTUNE_CONSTRUCTION_PREFETCH_DISTANCES[idx] });
+      const bff_for_kv_map_t filter(seed, keys_and_values.first, keys_and_values.second, plaintext_modulo, label);
+    });
+
+    tuning.construction_prefetch_distance = BFF_FOR_KV_MAP_AUTOTUNE_CONSTRUCTION_PREFETCH_DISTANCES[fastest_idx];
+  }
+
+  return tuning;
+}
+
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+
+namespace bff_kv_map {
+
+// Lower bound on fraction of time, a background construction may run for, so that it always makes progress.
+constexpr double BFF_FOR_KV_MAP_MIN_BUILD_CPU_FRACTION = 0.01;
+
+// Limits on the share of a host, construction may take, when filters are rebuilt on hosts, which are serving queries at the same time. Construction
+// then yields at chunk boundaries of its hashing, counting, peeling and assignment loops, so that query threads get CPU time, and caches, back.
+struct build_budget_t
+{
+  // Fraction of wall clock time, in (0, 1], each constructing thread spends running. After each chunk of work, it sleeps long enough to stay within
+  // this fraction, while with 1, it only yields its time slice.
+  double cpu_fraction = 0.5;
+  // Upper bound on number of threads, construction runs on. Construction always starts on the calling thread alone, and only if its first attempt
+  // fails, it races later attempts on up to these many threads, see `num_speculative_attempts`.
+  size_t max_num_threads = 1;
+  // Zero scratch space of construction with non-temporal stores, which bypass caches, instead of evicting lines of query threads sharing them.
+  bool use_non_temporal_stores = false;
+};
+
+// Keeps a constructing thread within its build budget, when `checkpoint` is called at chunk boundaries of its loops. It does nothing, without a budget.
+struct build_throttle_t
+{
+private:
+  const build_budget_t* budget = nullptr;
+  std::chrono::steady_clock::time_point resumed_at{};
+
+public:
+  explicit build_throttle_t(const build_budget_t* const budget)
+    : budget(budget)
+    , resumed_at(std::chrono::steady_clock::now())
+  {
+  }
+
+  // Whether scratch space is to be zeroed with non-temporal stores.
+  bool use_non_temporal_stores() const { return (budget != nullptr) && budget->use_non_temporal_stores; }
+
+  // Sleeps for as long as the thread must be idle, to have spent no more than the budgeted fraction of time since it last resumed, or yields, when
+  // budgeted to run all the time.
+  void checkpoint()
+  {
+    if (budget == nullptr) {
+      return;
+    }
+
+    const double cpu_fraction = std::clamp(budget->cpu_fraction, BFF_FOR_KV_MAP_MIN_BUILD_CPU_FRACTION, 1.);
+    if (cpu_fraction >= 1.) {
+      std::this_thread::yield();
+    } else {
+      const auto busy_for = std::chrono::duration<double>(std::chrono::steady_clock::now() - resumed_at);
+      std::this_thread::sleep_for(busy_for * ((1. - cpu_fraction) / cpu_fraction));
+    }
+
+    resumed_at = std::chrono::steady_clock::now();
+  }
+};
+
+}
@@ -0,0 +1,359 @@
+#pragma once
+#include "filter_for_kv_map.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Bounded-memory cache of deserialized Binary Fuse Filters for Key-Value Maps, for when there are many more serialized filters than can be resident
+// at once. Filters are identified by a 64 -bit id, and fetched on a miss, with a user supplied loader, returning serialized bytes of the filter.
+// Resident filters are evicted with the CLOCK algorithm, i.e. an approximation of LRU, until their total size fits the memory budget. Concurrent
+// requests for a filter, which is being loaded, share the same load. `prefetch` hints filters which are about to be queried, which are then loaded
+// by background threads, so that the query path doesn't wait for them.
+struct bff_for_kv_map_cache_t
+{
+public:
+  using filter_ptr_t = std::shared_ptr<const bff_for_kv_map_t>;
+  using loader_t = std::function<std::vector<uint8_t>(uint64_t)>;
+
+private:
+  // A slot on the clock, holding a resident filter, or none, when the slot is free.
+  struct entry_t
+  {
+    uint64_t filter_id = 0;
+    filter_ptr_t filter;
+    size_t num_bytes = 0;
+    mutable std::atomic<uint8_t> is_referenced{ 0 };
+  };
+
+  // A load, which has been requested, but not yet completed, along with whether some thread has started running it.
+  struct pending_load_t
+  {
+    std::promise<filter_ptr_t> promise;
+    std::shared_future<filter_ptr_t> future = promise.get_future().share();
+    bool is_started = false;
+  };
+
+  size_t max_num_bytes = 0;
+  loader_t load_filter_bytes;
+
+  mutable std::shared_mutex mutex;
+  std::deque<entry_t> clock;
+  std::vector<size_t> free_slots;
+  size_t clock_hand = 0;
+  size_t num_resident_bytes_total = 0;
+  std::unordered_map<uint64_t, size_t> resident_slots;
+  std::unordered_map<uint64_t, pending_load_t> pending_loads;
+  std::deque<uint64_t> load_queue;
+  std::condition_variable_any load_queue_cv;
+
+  std::atomic<uint64_t> num_hits_total{ 0 };
+  std::atomic<uint64_t> num_misses_total{ 0 };
+
+  // Declared last, so that loader threads are stopped and joined, before anything they touch is destroyed.
+  std::vector<std::jthread> loaders;
+
+public:
+  /**
+   * @brief Construct an empty cache of Binary Fuse Filters for Key-Value Maps.
+   *
+   * @param max_num_bytes Memory budget, in bytes, bounding the total serialized size of resident filters. A single filter larger than the budget is
+   * still admitted, after evicting every other filter.
+   * @param load_filter_bytes Loader, returning bytes of the filter with given id, as serialized by `bff_for_kv_map_t::serialize`. It's called from
+   * querying threads and background loader threads, possibly concurrently, for different ids. It may throw, to signal a failed load.
+   * @param num_loader_threads Number of background threads, running loads requested with `prefetch` or `get_async`, must be at least 1.
+   */
+  explicit bff_for_kv_map_cache_t(const size_t max_num_bytes, loader_t load_filter_bytes, const size_t num_loader_threads = 1)
+    : max_num_bytes(max_num_bytes)
+    , load_filter_bytes(std::move(load_filter_bytes))
+  {
+    if (num_loader_threads == 0) [[unlikely]] {
+      throw std::runtime_error("Filter cache needs at least one loader thread.");
+    }
+
+    loaders.reserve(num_loader_threads);
+    for (size_t i = 0; i < num_loader_threads; i++) {
+      loaders.emplace_back([this](std::stop_token stop_token) { run_loader(stop_token); });
+    }
+  }
+
+  bff_for_kv_map_cache_t(const bff_for_kv_map_cache_t&) = delete;
+  bff_for_kv_map_cache_t& operator=(const bff_for_kv_map_cache_t&) = delete;
+
+  /**
+   * @brief Destroy the cache, after stopping loader threads. Loads which haven't been started yet are abandoned, and their futures fail with
+   * `std::future_error`. Filters handed out earlier stay alive, as long as they're referenced.
+   */
+  ~bff_for_kv_map_cache_t()
+  {
+    for (auto& loader : loaders) {
+      loader.request_stop();
+    }
+    load_queue_cv.notify_all();
+  }
+
+  /**
+   * @brief Get the filter with given id, loading it on the calling thread, if it's neither resident nor already being loaded, otherwise waiting for the
+   * load in progress. A prefetched filter, whose load hasn't been picked up by a loader thread yet, is loaded on the calling thread.
+   *
+   * @param filter_id Id of the filter.
+   * @return The filter, which stays alive as long as it's referenced, even if evicted from the cache meanwhile.
+   */
+  filter_ptr_t get(const uint64_t filter_id)
+  {
+    if (auto filter = find_resident(filter_id)) {
+      num_hits_total.fetch_add(1, std::memory_order_relaxed);
+      return filter;
+    }
+
+    num_misses_total.fetch_add(1, std::memory_order_relaxed);
+    return request_load(filter_id, true).get();
+  }
+
+  /**
+   * @brief Get the filter with given id, without blocking. If it's neither resident nor already being loaded, it's loaded by a background loader thread.
+   *
+   * @param filter_id Id of the filter.
+   * @return A future, which becomes ready with the filter, or with the exception thrown while loading it.
+   */
+  std::shared_future<filter_ptr_t> get_async(const uint64_t filter_id)
+  {
+    if (auto filter = find_resident(filter_id)) {
+      num_hits_total.fetch_add(1, std::memory_order_relaxed);
+
+      std::promise<filter_ptr_t> promise;
+      promise.set_value(std::move(filter));
+      return promise.get_future().share();
+    }
+
+    num_misses_total.fetch_add(1, std::memory_order_relaxed);
+    return request_load(filter_id, false);
+  }
+
+  /**
+   * @brief Hint that the filter with given id is about to be queried, so that it's loaded by a background loader thread, unless it's already resident or
+   * being loaded. Doesn't count towards hits or misses.
+   *
+   * @param filter_id Id of the filter.
+   */
+  void prefetch(const uint64_t filter_id)
+  {
+    if (find_resident(filter_id)) {
+      return;
+    }
+
+    request_load(filter_id, false);
+  }
+
+  /**
+   * @brief Get the total serialized size of resident filters, in bytes.
+   *
+   * @return The number of bytes held by the cache.
+   */
+  size_t num_resident_bytes() const
+  {
+    std::shared_lock lock(mutex);
+    return num_resident_bytes_total;
+  }
+
+  /**
+   * @brief Get the number of resident filters.
+   *
+   * @return The number of filters held by the cache.
+   */
+  size_t num_resident_filters() const
+  {
+    std::shared_lock lock(mutex);
+    return resident_slots.size();
+  }
+
+  /**
+   * @brief Get the number of `get` and `get_async` calls, which found their filter resident.
+   *
+   * @return The number of cache hits.
+   */
+  uint64_t num_hits() const { return num_hits_total.load(std::memory_order_relaxed); }
+
+  /**
+   * @brief Get the number of `get` and `get_async` calls, which didn't find their filter resident, including those which waited for a load in progress.
+   *
+   * @return The number of cache misses.
+   */
+  uint64_t num_misses() const { return num_misses_total.load(std::memory_order_relaxed); }
+
+private:
+  // Looks up a resident filter, under a shared lock, marking it as referenced for CLOCK eviction.
+  filter_ptr_t find_resident(const uint64_t filter_id) const
+  {
+    std::shared_lock lock(mutex);
+
+    const auto it = resident_slots.find(filter_id);
+    if (it == resident_slots.end()) {
+      return nullptr;
+    }
+
+    const auto& entry = clock[it->second];
+    entry.is_referenced.store(1, std::memory_order_relaxed);
+    return entry.filter;
+  }
+
+  // Joins the load of given filter, if it's already requested, otherwise requests it. The load runs on the calling thread, if asked to and no thread has
+  // started it yet, otherwise it's left to a loader thread.
+  std::shared_future<filter_ptr_t> request_load(const uint64_t filter_id, const bool is_loaded_by_caller)
+  {
+    std::unique_lock lock(mutex);
+
+    if (const auto it = resident_slots.find(filter_id); it != resident_slots.end()) {
+      auto& entry = clock[it->second];
+      entry.is_referenced.store(1, std::memory_order_relaxed);
+
+      std::promise<filter_ptr_t> promise;
+      promise.set_value(entry.filter);
+      return promise.get_future().share();
+    }
+
+    auto [it, is_inserted] = pending_loads.try_emplace(filter_id);
+    auto& pending_load = it->second;
+    auto future = pending_load.future;
+
+    if (is_loaded_by_caller && !pending_load.is_started) {
+      pending_load.is_started = true;
+      lock.unlock();
+
+      load(filter_id);
+    } else if (is_inserted) {
+      load_queue.push_back(filter_id);
+      lock.unlock();
+
+      load_queue_cv.notify_one();
+    }
+
+    return future;
+  }
+
+  // Runs queued loads, skipping those which a querying thread has already started, until stop is requested.
+  void run_loader(std::stop_token stop_token)
+  {
+    while (true) {
+      std::unique_lock lock(mutex);
+      if (!load_queue_cv.wait(lock, stop_token, [&]() { return !load_queue.empty(); })) {
+        return;
+      }
+
+      const uint64_t filter_id = load_queue.front();
+      load_queue.pop_front();
+
+      const auto it = pending_loads.find(filter_id);
+      if ((it == pending_loads.end()) || it->second.is_started) {
+        continue;
+      }
+
+      it->second.is_started = true;
+      lock.unlock();
+
+      load(filter_id);
+    }
+  }
+
+  // Loads and deserializes given filter, admits it into the cache, and fulfills everyone waiting for it. A failed load isn't cached, so it's retried
+  // by the next request.
+  void load(const uint64_t filter_id)
+  {
+    filter_ptr_t filter;
+    std::exception_ptr error;
+
+    try {
+      const auto bytes = load_filter_bytes(filter_id);
+      filter = std::make_shared<const bff_for_kv_map_t>(std::span<const uint8_t>(bytes));
+    } catch (...) {
+      error = std::current_exception();
+    }
+
+    std::unique_lock lock(mutex);
+
+    auto pending_load = std::move(pending_loads.extract(filter_id).mapped());
+    if (filter) {
+      admit(filter_id, filter);
+    }
+
+    lock.unlock();
+
+    if (filter) {
+      pending_load.promise.set_value(std::move(filter));
+    } else {
+      pending_load.promise.set_exception(error);
+    }
+  }
+
+  // Inserts a filter into a free clock slot, after evicting filters, until it fits the memory budget. Must be called with exclusive lock held.
+  void admit(const uint64_t filter_id, filter_ptr_t filter)
+  {
+    const size_t num_bytes = filter->serialized_num_bytes();
+    while ((num_resident_bytes_total + num_bytes > max_num_bytes) && !resident_slots.empty()) {
+      evict_one();
+    }
+
+    size_t slot = 0;
+    if (free_slots.empty()) {
+      slot = clock.size();
+      clock.emplace_back();
+    } else {
+      slot = free_slots.back();
+      free_slots.pop_back();
+    }
+
+    auto& entry = clock[slot];
+    entry.filter_id = filter_id;
+    entry.filter = std::move(filter);
+    entry.num_bytes = num_bytes;
+    entry.is_referenced.store(1, std::memory_order_relaxed);
+
+    resident_slots.emplace(filter_id, slot);
+    num_resident_bytes_total += num_bytes;
+  }
+
+  // Sweeps the clock hand, giving referenced filters a second chance, until it evicts one which hasn't been referenced since the last sweep. Must be
+  // called with exclusive lock held, while at least one filter is resident.
+  void evict_one()
+  {
+    while (true) {
+      auto& entry = clock[clock_hand];
+      const size_t slot = clock_hand;
+      clock_hand = (clock_hand + 1) % clock.size();
+
+      if (!entry.filter) {
+        continue;
+      }
+      if (entry.is_referenced.exchange(0, std::memory_order_relaxed) != 0) {
+        continue;
+      }
+
+      resident_slots.erase(entry.filter_id);
+      num_resident_bytes_total -= entry.num_bytes;
+
+      entry.filter.reset();
+      entry.num_bytes = 0;
+      free_slots.push_back(slot);
+
+      return;
+    }
+  }
+};
+
+}
@@ -1,27 +1,55 @@
 #pragma once
+#include "build_budget.hpp"
+#include "numa.hpp"
+#include "tuning.hpp"
 #include "utils.hpp"
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <exception>
+#include <limits>
+#include <optional>
 #include <span>
 #include <stdexcept>
+#include <thread>
 #include <tuple>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace bff_kv_map {
 
 constexpr size_t BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT = 100;
+constexpr uint32_t BFF_FOR_KV_MAP_MAX_SEGMENT_LENGTH = 262144;
+constexpr double BFF_FOR_KV_MAP_MIN_SIZE_FACTOR = 1.125;
+constexpr size_t BFF_FOR_KV_MAP_MIN_UNPEELED_KEY_COUNT = 64;
+// At most one in these many keys may be left unpeeled, and stashed, by the cache- and TLB-local variant. Some 110-140 keys end up unpeeled at 10M
+// keys, so the bound of ~610 leaves ~5x headroom, while keeping stashes small.
+constexpr size_t BFF_FOR_KV_MAP_KEYS_PER_UNPEELED_KEY = 16384;
+// Number of keys hashed or peeled by a construction attempt, or slots counted, between checks for whether it has been outrun by another speculative
+// attempt, and for whether it should yield, when built within a `build_budget_t`.
+constexpr uint32_t BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL = 16384;
+// Slot ranges of a sub-filter, separated by a gap of at most these many slots, are coalesced. Shipping gap fingerprints then costs no more than
+// an extra entry in the range table.
+constexpr uint32_t BFF_FOR_KV_MAP_SUB_FILTER_MAX_SLOT_GAP = 2;
+
+// Key-Value Maps with at most these many keys are built on a compact path, whose key indices fit in 16 -bit, keeping its whole working set resident
+// in L1/L2 cache.
+constexpr uint32_t BFF_FOR_KV_MAP_SMALL_MAX_KEY_COUNT = 1U << 16;
+
+struct bff_for_kv_map_set_t;
+struct bff_for_kv_map_pir_batch_t;
 
 // Binary Fuse Filter for Key Value Maps with ability to reconstruct values when queried with keys.
 // Collects inspiration from @ https://github.com/claucece/chalamet/tree/515ff1479940a2917ad247acb6ab9e6d27e139a1/bff-modp.
 struct bff_for_kv_map_t
 {
-private:
+protected:
   std::array<uint8_t, 32> seed{};
 
   uint32_t num_keys_in_kv_map = 0;
@@ -35,9 +63,37 @@ private:
   uint32_t array_length = 0;
   std::vector<uint32_t> fingerprints;
 
+  friend struct bff_for_kv_map_set_t;
+  friend struct bff_for_kv_map_pir_batch_t;
+
 public:
   bff_for_kv_map_t() = default;
 
+  // Filters own up to hundreds of megabytes of fingerprints, so they're never copied implicitly. Serialize a filter, to make an independent copy of it.
+  bff_for_kv_map_t(const bff_for_kv_map_t&) = delete;
+  bff_for_kv_map_t& operator=(const bff_for_kv_map_t&) = delete;
+
+  /**
+   * @brief Move construct a Binary Fuse Filter for Key-Value Map, taking over fingerprints of the source, without copying them. The source is left as
+   * a default constructed filter, with its seed and parameters wiped.
+   *
+   * @param other The filter to move from.
+   */
+  bff_for_kv_map_t(bff_for_kv_map_t&& other) noexcept { swap(other); }
+
+  /**
+   * @brief Move assign a Binary Fuse Filter for Key-Value Map, taking over fingerprints of the source, without copying them. Fingerprints held before
+   * assignment are wiped, and the source is left as a default constructed filter.
+   *
+   * @param other The filter to move from.
+   * @return This filter.
+   */
+  bff_for_kv_map_t& operator=(bff_for_kv_map_t&& other) noexcept
+  {
+    bff_for_kv_map_t(std::move(other)).swap(*this);
+    return *this;
+  }
+
   /**
    * @brief Construct a Binary Fuse Filter for Key-Value Map.
    *
@@ -46,197 +102,61 @@ public:
    * @param values The values of the Key-Value Map s.t. value ∈ [0,plaintext_modulo)
    * @param plaintext_modulo The plaintext modulo to use.
    * @param label The label to use.
+   * @param num_speculative_attempts If > 1, construction attempts, each under a different tweak of the seed, are raced on these many threads, bounding
+   * tail construction latency on multi-core machines. The resulting filter is the same as when attempted serially, see `get_seed` for the seed it uses.
    */
   explicit bff_for_kv_map_t(std::span<const uint8_t, 32> seed_bytes,
                             std::span<const bff_kv_map_utils::bff_key_t> keys,
                             std::span<const uint32_t> values,
                             const uint64_t plaintext_modulo,
-                            const uint64_t label)
+                            const uint64_t label,
+                            const size_t num_speculative_attempts = 1)
   {
-    if (keys.size() != values.size()) [[unlikely]] {
-      throw std::runtime_error("Number of keys and values must be equal.");
-    }
-    if (!bff_kv_map_utils::are_all_keys_distinct(keys)) [[unlikely]] {
-      throw std::runtime_error("All keys must be unique.");
-    }
-    if (plaintext_modulo < 256) [[unlikely]] {
-      throw std::runtime_error("Plaintext modulo must be >= 256.");
-    }
-
-    num_keys_in_kv_map = keys.size();
-    std::copy(seed_bytes.begin(), seed_bytes.end(), this->seed.begin());
-
-    constexpr uint32_t arity = 3;
-    segment_length = num_keys_in_kv_map == 0 ? 4 : bff_kv_map_utils::calculate_segment_length(arity, num_keys_in_kv_map);
-    if (segment_length > 262144) {
-      segment_length = 262144;
-    }
-
-    segment_length_mask = segment_length - 1;
-
-    const double sizeFactor = num_keys_in_kv_map <= 1 ? 0 : bff_kv_map_utils::calculate_size_factor(arity, num_keys_in_kv_map);
-    const uint32_t capacity = num_keys_in_kv_map <= 1 ? 0 : static_cast<uint32_t>(round(static_cast<double>(num_keys_in_kv_map) * sizeFactor));
-    const uint32_t initSegmentCount = (capacity + segment_length - 1) / segment_length - (arity - 1);
-
-    array_length = (initSegmentCount + arity - 1) * segment_length;
-    segment_count = (array_length + segment_length - 1) / segment_length;
-
-    if (segment_count <= arity - 1) {
-      segment_count = 1;
-    } else {
-      segment_count = segment_count - (arity - 1);
-    }
-
-    array_length = (segment_count + arity - 1) * segment_length;
-    segment_count_length = segment_count * segment_length;
-
-    fingerprints = std::vector<uint32_t>(array_length, 0);
-
-    this->plaintext_modulo = plaintext_modulo;
-    this->label = label;
-
-    std::vector<uint64_t> reverseOrder(num_keys_in_kv_map + 1, 0);
-    std::vector<uint8_t> reverseH(num_keys_in_kv_map, 0);
-    std::vector<uint32_t> alone(array_length, 0);
-    std::vector<uint8_t> t2count(array_length, 0);
-    std::vector<uint64_t> t2hash(array_length, 0);
-
-    uint32_t block_bits = 1;
-    while ((1U << block_bits) < segment_count) {
-      block_bits++;
-    }
-
-    const uint32_t block_size = 1U << block_bits;
-    std::vector<uint32_t> startPos(block_size, 0);
-
-    std::array<uint32_t, 5> h012{};
-    reverseOrder[num_keys_in_kv_map] = 1;
-
-    std::unordered_map<uint64_t, uint32_t> hm_keys{};
-
-    for (size_t loop = 0; true; loop++) {
-      if ((loop + 1) > BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT) [[unlikely]] {
-        throw std::runtime_error("Failed to construct Binary Fuse Filter for input Key-Value Map.");
-      }
-
-      for (uint32_t i = 0; i < block_size; i++) {
-        startPos[i] = static_cast<uint32_t>((static_cast<uint64_t>(i) * static_cast<uint64_t>(num_keys_in_kv_map)) >> block_bits);
-      }
-
-      uint64_t maskblock = block_size - 1;
-      for (uint32_t i = 0; i < num_keys_in_kv_map; i++) {
-        const uint64_t hash = bff_kv_map_utils::mix256(keys[i].words, seed_bytes);
-
-        uint64_t segment_index = hash >> (64 - block_bits);
-        while (reverseOrder[startPos[segment_index]] != 0) {
-          segment_index++;
-          segment_index &= maskblock;
-        }
-
-        reverseOrder[startPos[segment_index]] = hash;
-        startPos[segment_index]++;
-
-        hm_keys[hash] = values[i];
-      }
-
-      bool error = 0;
-      for (uint32_t i = 0; i < num_keys_in_kv_map; i++) {
-        const uint64_t hash = reverseOrder[i];
-        const auto [h0, h1, h2] = hash_batch(hash);
-
-        t2count[h0] += 4;
-        t2hash[h0] ^= hash;
-
-        t2count[h1] += 4;
-        t2count[h1] ^= 1U;
-        t2hash[h1] ^= hash;
-
-        t2count[h2] += 4;
-        t2hash[h2] ^= hash;
-        t2count[h2] ^= 2U;
-
-        error = (t2count[h0] < 4) || (t2count[h1] < 4) || (t2count[h2] < 4);
-      }
-
-      if (error) {
-        std::fill_n(reverseOrder.begin(), reverseOrder.size() - 1, 0);
-        std::fill(t2count.begin(), t2count.end(), 0);
-        std::fill(t2hash.begin(), t2hash.end(), 0);
-
-        continue;
-      }
-
-      uint32_t Qsize = 0;
-      for (uint32_t i = 0; i < array_length; i++) {
-        alone[Qsize] = i;
-        Qsize += ((t2count[i] >> 2U) == 1) ? 1U : 0U;
-      }
-
-      uint32_t stacksize = 0;
-      while (Qsize > 0) {
-        Qsize--;
-        const uint32_t index = alone[Qsize];
-
-        if ((t2count[index] >> 2U) == 1) {
-          const uint64_t hash = t2hash[index];
-
-          const uint8_t found = t2count[index] & 3U;
-          reverseH[stacksize] = found;
-          reverseOrder[stacksize] = hash;
-          stacksize++;
-
-          const auto [h0, h1, h2] = hash_batch(hash);
-
-          h012[1] = h1;
-          h012[2] = h2;
-          h012[3] = h0;
-          h012[4] = h012[1];
-
-          const uint32_t other_index1 = h012[found + 1];
-          alone[Qsize] = other_index1;
-          Qsize += ((t2count[other_index1] >> 2U) == 2 ? 1U : 0U);
-
-          t2count[other_index1] -= 4;
-          t2count[other_index1] ^= bff_kv_map_utils::mod3(found + 1);
-          t2hash[other_index1] ^= hash;
-
-          const uint32_t other_index2 = h012[found + 2];
-          alone[Qsize] = other_index2;
-          Qsize += ((t2count[other_index2] >> 2U) == 2 ? 1U : 0U);
-
-          t2count[other_index2] -= 4;
-          t2count[other_index2] ^= bff_kv_map_utils::mod3(found + 2);
-          t2hash[other_index2] ^= hash;
-        }
-      }
-
-      if (stacksize == num_keys_in_kv_map) {
-        break;
-      }
+    build(seed_bytes,
+          keys,
+          values,
+          plaintext_modulo,
+          label,
+          BFF_FOR_KV_MAP_MAX_SEGMENT_LENGTH,
+          BFF_FOR_KV_MAP_MIN_SIZE_FACTOR,
+          nullptr,
+          num_speculative_attempts,
+          nullptr);
+  }
 
-      std::fill_n(reverseOrder.begin(), reverseOrder.size() - 1, 0);
-      std::fill(t2count.begin(), t2count.end(), 0);
-      std::fill(t2hash.begin(), t2hash.end(), 0);
+  /**
+   * @brief Construct a Binary Fuse Filter for Key-Value Map in background, on a host serving queries, within a budget of CPU time and threads. The
+   * resulting filter is the same as when constructed flat out.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param values The values of the Key-Value Map s.t. value ∈ [0,plaintext_modulo)
+   * @param plaintext_modulo The plaintext modulo to use.
+   * @param label The label to use.
+   * @param budget Fraction of time construction may run for, number of threads it may run on, and whether it zeroes scratch space with
+   * non-temporal stores. Construction runs on the calling thread alone, using more threads only for attempts after the first one fails.
+   */
+  explicit bff_for_kv_map_t(std::span<const uint8_t, 32> seed_bytes,
+                            std::span<const bff_kv_map_utils::bff_key_t> keys,
+                            std::span<const uint32_t> values,
+                            const uint64_t plaintext_modulo,
+                            const uint64_t label,
+                            const build_budget_t& budget)
+  {
+    if (!(budget.cpu_fraction > 0.) || (budget.cpu_fraction > 1.) || (budget.max_num_threads == 0)) [[unlikely]] {
+      throw std::runtime_error("Build budget must allow a CPU fraction in (0, 1], on at least one thread.");
     }
 
-    for (uint32_t i = num_keys_in_kv_map - 1; i < num_keys_in_kv_map; i--) {
-      const uint64_t hash = reverseOrder[i];
-      const uint32_t value = hm_keys[hash];
-
-      const auto [h0, h1, h2] = hash_batch(hash);
-
-      const uint8_t found = reverseH[i];
-      h012[0] = h0;
-      h012[1] = h1;
-      h012[2] = h2;
-      h012[3] = h012[0];
-      h012[4] = h012[1];
-
-      const uint32_t entry = ((value % plaintext_modulo) - fingerprints[h012[found + 1]] - fingerprints[h012[found + 2]]) % plaintext_modulo;
-      const uint32_t mask = bff_kv_map_utils::mix(hash, label) % plaintext_modulo;
-
-      fingerprints[h012[found]] = (entry - mask) % plaintext_modulo;
-    }
+    build(seed_bytes,
+          keys,
+          values,
+          plaintext_modulo,
+          label,
+          BFF_FOR_KV_MAP_MAX_SEGMENT_LENGTH,
+          BFF_FOR_KV_MAP_MIN_SIZE_FACTOR,
+          nullptr,
+          budget.max_num_threads,
+          &budget);
   }
 
   /**
@@ -279,11 +199,12 @@ public:
   }
 
   /**
-   * @brief Destroy the Binary Fuse Filter for Key-Value Map, while zeroing out data members.
+   * @brief Destroy the Binary Fuse Filter for Key-Value Map, while zeroing out data members, including fingerprints, before their memory is freed.
    */
   ~bff_for_kv_map_t()
   {
-    seed.fill(0);
+    bff_kv_map_utils::secure_wipe(std::span(seed));
+    bff_kv_map_utils::secure_wipe(std::span(fingerprints));
 
     num_keys_in_kv_map = 0;
     plaintext_modulo = 0;
@@ -297,6 +218,36 @@ public:
     fingerprints.clear();
   }
 
+  /**
+   * @brief Swap two Binary Fuse Filters for Key-Value Map, without copying their fingerprints.
+   *
+   * @param other The filter to swap with.
+   */
+  void swap(bff_for_kv_map_t& other) noexcept
+  {
+    std::swap(seed, other.seed);
+
+    std::swap(num_keys_in_kv_map, other.num_keys_in_kv_map);
+    std::swap(plaintext_modulo, other.plaintext_modulo);
+    std::swap(label, other.label);
+
+    std::swap(segment_length, other.segment_length);
+    std::swap(segment_length_mask, other.segment_length_mask);
+    std::swap(segment_count, other.segment_count);
+    std::swap(segment_count_length, other.segment_count_length);
+    std::swap(array_length, other.array_length);
+    fingerprints.swap(other.fingerprints);
+  }
+
+  friend void swap(bff_for_kv_map_t& lhs, bff_for_kv_map_t& rhs) noexcept { lhs.swap(rhs); }
+
+  /**
+   * @brief Get the seed, keys are hashed with. It differs from the seed passed to the constructor, if the first construction attempt failed.
+   *
+   * @return The seed bytes.
+   */
+  std::array<uint8_t, 32> get_seed() const { return seed; }
+
   /**
    * @brief Get the number of bits per entry in the Binary Fuse Filter.
    *
@@ -309,11 +260,7 @@ public:
    *
    * @return The size in bytes.
    */
-  size_t serialized_num_bytes() const
-  {
-    return sizeof(seed) + sizeof(num_keys_in_kv_map) + sizeof(plaintext_modulo) + sizeof(label) + sizeof(segment_length) + sizeof(segment_count) +
-           sizeof(segment_count_length) + sizeof(array_length) + (fingerprints.size() * sizeof(uint32_t));
-  }
+  size_t serialized_num_bytes() const { return header_num_bytes() + (fingerprints.size() * sizeof(uint32_t)); }
 
   /**
    * @brief Serialize the Binary Fuse Filter to a byte array.
@@ -327,51 +274,215 @@ public:
       return false;
     }
 
-    size_t buffer_offset = 0;
-    std::copy_n(seed.begin(), seed.size(), bytes.begin());
+    const size_t buffer_offset = serialize_header(bytes);
+    std::copy_n(reinterpret_cast<const uint8_t*>(fingerprints.data()), array_length * sizeof(uint32_t), bytes.subspan(buffer_offset).begin());
 
-    buffer_offset += seed.size();
-    std::copy_n(reinterpret_cast<const uint8_t*>(&num_keys_in_kv_map), sizeof(num_keys_in_kv_map), bytes.subspan(buffer_offset).begin());
+    return true;
+  }
 
-    buffer_offset += sizeof(num_keys_in_kv_map);
-    std::copy_n(reinterpret_cast<const uint8_t*>(&plaintext_modulo), sizeof(plaintext_modulo), bytes.subspan(buffer_offset).begin());
+  /**
+   * @brief Extract a compact sub-filter, holding only those fingerprints, which are needed for recovering values associated with given keys.
+   * Recover from it using `bff_for_kv_map_sub_filter_view_t`.
+   *
+   * Layout: header, same as in `serialize` || number of slot ranges (u32) || first slot and number of slots of each range (u32, u32) ||
+   * fingerprints of all ranges, back to back (u32 each). Ranges are sorted, non-overlapping and separated by more than
+   * `BFF_FOR_KV_MAP_SUB_FILTER_MAX_SLOT_GAP` slots.
+   *
+   * @param keys The keys, a client wants to recover values for. They need not be distinct.
+   * @return The serialized sub-filter.
+   */
+  std::vector<uint8_t> extract_sub_filter(std::span<const bff_kv_map_utils::bff_key_t> keys) const
+  {
+    std::vector<uint32_t> slots;
+    slots.reserve(keys.size() * 3);
 
-    buffer_offset += sizeof(plaintext_modulo);
-    std::copy_n(reinterpret_cast<const uint8_t*>(&label), sizeof(label), bytes.subspan(buffer_offset).begin());
+    for (const auto& key : keys) {
+      const auto [h0, h1, h2] = hash_batch(hash_key(key));
 
-    buffer_offset += sizeof(label);
+      slots.push_back(h0);
+      slots.push_back(h1);
+      slots.push_back(h2);
+    }
+
+    std::sort(slots.begin(), slots.end());
+    slots.erase(std::unique(slots.begin(), slots.end()), slots.end());
+
+    std::vector<std::pair<uint32_t, uint32_t>> ranges;
+    size_t num_fingerprints = 0;
+
+    for (const auto slot : slots) {
+      if (!ranges.empty() && ((slot - (ranges.back().first + ranges.back().second)) <= BFF_FOR_KV_MAP_SUB_FILTER_MAX_SLOT_GAP)) {
+        num_fingerprints += slot - (ranges.back().first + ranges.back().second) + 1;
+        ranges.back().second = slot - ranges.back().first + 1;
+      } else {
+        num_fingerprints += 1;
+        ranges.emplace_back(slot, 1);
+      }
+    }
+
+    const auto num_ranges = static_cast<uint32_t>(ranges.size());
+    std::vector<uint8_t> bytes(header_num_bytes() + sizeof(num_ranges) + (ranges.size() * 2 * sizeof(uint32_t)) + (num_fingerprints * sizeof(uint32_t)));
+
+    size_t buffer_offset = serialize_header(bytes);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&num_ranges), sizeof(num_ranges), bytes.begin() + buffer_offset);
+
+    buffer_offset += sizeof(num_ranges);
+    for (const auto& [first_slot, num_slots] : ranges) {
+      std::copy_n(reinterpret_cast<const uint8_t*>(&first_slot), sizeof(first_slot), bytes.begin() + buffer_offset);
+      buffer_offset += sizeof(first_slot);
+
+      std::copy_n(reinterpret_cast<const uint8_t*>(&num_slots), sizeof(num_slots), bytes.begin() + buffer_offset);
+      buffer_offset += sizeof(num_slots);
+    }
+
+    for (const auto& [first_slot, num_slots] : ranges) {
+      std::copy_n(reinterpret_cast<const uint8_t*>(fingerprints.data() + first_slot), num_slots * sizeof(uint32_t), bytes.begin() + buffer_offset);
+      buffer_offset += num_slots * sizeof(uint32_t);
+    }
+
+    return bytes;
+  }
+
+  /**
+   * @brief Get the size of the Binary Fuse Filter, when serialized in the layout of Rust crate `bff-modp`, in bytes.
+   *
+   * @return The size in bytes.
+   */
+  size_t bff_modp_serialized_num_bytes() const
+  {
+    return sizeof(seed) + sizeof(segment_length) + sizeof(segment_length_mask) + sizeof(segment_count) + sizeof(segment_count_length) + sizeof(uint64_t) +
+           (fingerprints.size() * sizeof(uint32_t));
+  }
+
+  /**
+   * @brief Serialize the Binary Fuse Filter in the layout of Rust crate `bff-modp` i.e. bincode encoding of its `BinaryFuseP32` struct.
+   *
+   * Layout: seed (32 bytes) || segment_length (u32) || segment_length_mask (u32) || segment_count (u32) || segment_count_length (u32) ||
+   * number of fingerprints (u64) || fingerprints (u32 each), with all integers little-endian. Number of keys, plaintext modulo and label
+   * are not part of this layout, they must be communicated out-of-band. The layout follows the crate's source, but hasn't been verified against
+   * bytes produced by the crate.
+   *
+   * @param bytes The byte array to serialize to.
+   * @return True if serialization was successful, false otherwise.
+   */
+  bool serialize_as_bff_modp(std::span<uint8_t> bytes) const
+  {
+    if (bytes.size() != bff_modp_serialized_num_bytes()) [[unlikely]] {
+      return false;
+    }
+
+    size_t buffer_offset = 0;
+    std::copy_n(seed.begin(), seed.size(), bytes.begin());
+
+    buffer_offset += seed.size();
     std::copy_n(reinterpret_cast<const uint8_t*>(&segment_length), sizeof(segment_length), bytes.subspan(buffer_offset).begin());
 
     buffer_offset += sizeof(segment_length);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&segment_length_mask), sizeof(segment_length_mask), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(segment_length_mask);
     std::copy_n(reinterpret_cast<const uint8_t*>(&segment_count), sizeof(segment_count), bytes.subspan(buffer_offset).begin());
 
     buffer_offset += sizeof(segment_count);
     std::copy_n(reinterpret_cast<const uint8_t*>(&segment_count_length), sizeof(segment_count_length), bytes.subspan(buffer_offset).begin());
 
     buffer_offset += sizeof(segment_count_length);
-    std::copy_n(reinterpret_cast<const uint8_t*>(&array_length), sizeof(array_length), bytes.subspan(buffer_offset).begin());
+    const uint64_t num_fingerprints = fingerprints.size();
+    std::copy_n(reinterpret_cast<const uint8_t*>(&num_fingerprints), sizeof(num_fingerprints), bytes.subspan(buffer_offset).begin());
 
-    buffer_offset += sizeof(array_length);
-    std::copy_n(reinterpret_cast<const uint8_t*>(fingerprints.data()), array_length * sizeof(uint32_t), bytes.subspan(buffer_offset).begin());
+    buffer_offset += sizeof(num_fingerprints);
+    std::copy_n(reinterpret_cast<const uint8_t*>(fingerprints.data()), fingerprints.size() * sizeof(uint32_t), bytes.subspan(buffer_offset).begin());
 
     return true;
   }
 
+  /**
+   * @brief Construct a Binary Fuse Filter for Key-Value Map from bytes serialized in the layout of Rust crate `bff-modp`. The layout follows the
+   * crate's source, but hasn't been verified against bytes produced by the crate, so treat filters built on the Rust side as untested.
+   * Plaintext modulo and segment layout are validated as on construction, so malformed bytes are rejected, instead of probing out of bounds.
+   *
+   * @param bytes The serialized bytes, see `serialize_as_bff_modp` for the layout.
+   * @param num_keys_in_kv_map The number of keys the filter was built over.
+   * @param plaintext_modulo The plaintext modulo the filter was built with.
+   * @param label The label the filter was built with.
+   * @return The deserialized filter.
+   */
+  static bff_for_kv_map_t from_bff_modp_bytes(std::span<const uint8_t> bytes,
+                                              const uint32_t num_keys_in_kv_map,
+                                              const uint64_t plaintext_modulo,
+                                              const uint64_t label)
+  {
+    if (plaintext_modulo < 256) [[unlikely]] {
+      throw std::runtime_error("Plaintext modulo must be >= 256.");
+    }
+
+    bff_for_kv_map_t filter;
+
+    constexpr size_t header_num_bytes = sizeof(filter.seed) + sizeof(filter.segment_length) + sizeof(filter.segment_length_mask) +
+                                        sizeof(filter.segment_count) + sizeof(filter.segment_count_length) + sizeof(uint64_t);
+    if (bytes.size() < header_num_bytes) [[unlikely]] {
+      throw std::runtime_error("Serialized bff-modp filter is too short.");
+    }
+
+    size_t buffer_offset = 0;
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), filter.seed.size(), filter.seed.begin());
+    buffer_offset += filter.seed.size();
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(filter.segment_length), reinterpret_cast<uint8_t*>(&filter.segment_length));
+    buffer_offset += sizeof(filter.segment_length);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(filter.segment_length_mask), reinterpret_cast<uint8_t*>(&filter.segment_length_mask));
+    buffer_offset += sizeof(filter.segment_length_mask);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(filter.segment_count), reinterpret_cast<uint8_t*>(&filter.segment_count));
+    buffer_offset += sizeof(filter.segment_count);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(filter.segment_count_length), reinterpret_cast<uint8_t*>(&filter.segment_count_length));
+    buffer_offset += sizeof(filter.segment_count_length);
+
+    uint64_t num_fingerprints = 0;
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(num_fingerprints), reinterpret_cast<uint8_t*>(&num_fingerprints));
+    buffer_offset += sizeof(num_fingerprints);
+
+    const bool is_consistent = (num_fingerprints <= std::numeric_limits<uint32_t>::max()) && (filter.segment_length_mask == filter.segment_length - 1) &&
+                               bff_kv_map_utils::is_consistent_segment_layout(
+                                 filter.segment_length, filter.segment_count, filter.segment_count_length, static_cast<uint32_t>(num_fingerprints)) &&
+                               ((bytes.size() - buffer_offset) == num_fingerprints * sizeof(uint32_t));
+    if (!is_consistent) [[unlikely]] {
+      throw std::runtime_error("Serialized bff-modp filter is malformed.");
+    }
+
+    filter.num_keys_in_kv_map = num_keys_in_kv_map;
+    filter.plaintext_modulo = plaintext_modulo;
+    filter.label = label;
+    filter.array_length = static_cast<uint32_t>(num_fingerprints);
+
+    filter.fingerprints = std::vector<uint32_t>(filter.array_length, 0);
+    std::copy_n(bytes.subspan(buffer_offset).begin(), filter.array_length * sizeof(uint32_t), reinterpret_cast<uint8_t*>(filter.fingerprints.data()));
+
+    return filter;
+  }
+
   /**
    * @brief Recover the value associated with a given key.
    *
    * @param key The key to query.
    * @return The value associated with the key.
    */
-  uint32_t recover(const bff_kv_map_utils::bff_key_t key) const
-  {
-    const uint64_t hash = bff_kv_map_utils::mix256(key.words, seed);
-    const auto [h0, h1, h2] = hash_batch(hash);
+  uint32_t recover(const bff_kv_map_utils::bff_key_t key) const { return recover_from_hash(hash_key(key)); }
 
-    const uint32_t data = fingerprints[h0] + fingerprints[h1] + fingerprints[h2];
-    const uint32_t mask = bff_kv_map_utils::mix(hash, label) % plaintext_modulo;
-
-    return (data + mask) % plaintext_modulo;
+  /**
+   * @brief Recover values associated with many keys. Keys are processed in batches of `tuning_t::recover_batch_size`, hashing all keys of a
+   * batch and prefetching their fingerprint slots, before summing up any fingerprints, so that cache misses of different keys overlap.
+   *
+   * @param keys The keys to query.
+   * @param values The array to write recovered values to, must be as long as keys.
+   * @return True if values were recovered, false if lengths of keys and values differ.
+   */
+  bool recover_batch(std::span<const bff_kv_map_utils::bff_key_t> keys, std::span<uint32_t> values) const
+  {
+    return recover_batch_with_lookup(keys, values, [](const uint64_t) -> std::optional<uint32_t> { return std::nullopt; });
   }
 
   /**
@@ -417,20 +528,802 @@ public:
     return bff_kv_map_utils::mix(hash, label);
   }
 
-private:
-  constexpr std::tuple<uint32_t, uint32_t, uint32_t> hash_batch(const uint64_t hash) const
+protected:
+  // Scratch space and outcome of one attempt at peeling the fuse graph of keys, hashed under the seed of that attempt.
+  struct peeling_attempt_t
   {
-    const uint64_t hi = bff_kv_map_utils::mulhi(hash, this->segment_count_length);
+    size_t attempt = 0;
+    bool is_peeled = false;
+    std::array<uint8_t, 32> seed{};
 
-    uint32_t h0 = 0, h1 = 0, h2 = 0;
+    bff_kv_map_utils::scratch_vector_t<uint64_t> reverseOrder;
+    bff_kv_map_utils::scratch_vector_t<uint8_t> reverseH;
+    bff_kv_map_utils::scratch_vector_t<uint32_t> alone;
+    bff_kv_map_utils::scratch_vector_t<uint8_t> t2count;
+    bff_kv_map_utils::scratch_vector_t<uint64_t> t2hash;
+    bff_kv_map_utils::scratch_vector_t<uint32_t> startPos;
 
-    h0 = (uint32_t)hi;
-    h1 = h0 + this->segment_length;
-    h2 = h1 + this->segment_length;
-    h1 ^= (uint32_t)(hash >> 18U) & this->segment_length_mask;
-    h2 ^= (uint32_t)(hash) & this->segment_length_mask;
+    // Maps hash of each key to its index in input.
+    std::unordered_map<uint64_t, uint32_t> hm_keys;
+    uint32_t num_peeled_keys = 0;
 
-    return { h0, h1, h2 };
+    // NUMA node, which the attempt ran on, and so its scratch space resides on, or -1, if it wasn't bound to a node.
+    int numa_node = -1;
+  };
+
+  /**
+   * @brief Build the Binary Fuse Filter for Key-Value Map, with custom bounds on its segment layout.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param values The values of the Key-Value Map s.t. value ∈ [0,plaintext_modulo)
+   * @param plaintext_modulo The plaintext modulo to use.
+   * @param label The label to use.
+   * @param max_segment_length Upper bound on segment length, must be a power of 2. Three probes of a key always fall within three consecutive segments.
+   * @param min_size_factor Lower bound on the ratio of number of fingerprints to number of keys.
+   * @param unpeeled_keys If not null, keys left in the core of the fuse graph, as (hash, value) pairs sorted by hash, are moved here instead of
+   * failing construction, as long as there are at most `max(BFF_FOR_KV_MAP_MIN_UNPEELED_KEY_COUNT, num_keys / BFF_FOR_KV_MAP_KEYS_PER_UNPEELED_KEY)`
+   * of them. Those keys can't be recovered from fingerprints.
+   * @param num_speculative_attempts Number of construction attempts to race on parallel threads, attempts are serial if <= 1. Serially attempted
+   * filters, with no unpeeled keys allowed and at most `BFF_FOR_KV_MAP_SMALL_MAX_KEY_COUNT` keys, are built on the compact path,
+   * which results in the very same filter.
+   * @param budget If not null, construction yields at chunk boundaries of its loops, to stay within this budget, see `build_budget_t`.
+   */
+  void build(std::span<const uint8_t, 32> seed_bytes,
+             std::span<const bff_kv_map_utils::bff_key_t> keys,
+             std::span<const uint32_t> values,
+             const uint64_t plaintext_modulo,
+             const uint64_t label,
+             const uint32_t max_segment_length,
+             const double min_size_factor,
+             std::vector<std::pair<uint64_t, uint32_t>>* const unpeeled_keys,
+             const size_t num_speculative_attempts,
+             const build_budget_t* const budget)
+  {
+    if (keys.size() != values.size()) [[unlikely]] {
+      throw std::runtime_error("Number of keys and values must be equal.");
+    }
+
+    build_throttle_t throttle(budget);
+
+    validate_and_lay_out(keys, plaintext_modulo, label, max_segment_length, min_size_factor);
+    throttle.checkpoint();
+
+    if ((unpeeled_keys == nullptr) && (num_speculative_attempts <= 1) && (keys.size() <= BFF_FOR_KV_MAP_SMALL_MAX_KEY_COUNT)) {
+      build_small(seed_bytes, keys, values, throttle);
+      return;
+    }
+
+    const size_t max_unpeeled_key_count =
+      (unpeeled_keys == nullptr) ? 0 : std::max<size_t>(BFF_FOR_KV_MAP_MIN_UNPEELED_KEY_COUNT, keys.size() / BFF_FOR_KV_MAP_KEYS_PER_UNPEELED_KEY);
+    auto peeling = find_peeling(seed_bytes, keys, max_unpeeled_key_count, num_speculative_attempts, budget);
+
+    const auto& reverseOrder = peeling.reverseOrder;
+    const auto& reverseH = peeling.reverseH;
+    auto& hm_keys = peeling.hm_keys;
+    const uint32_t num_peeled_keys = peeling.num_peeled_keys;
+
+    const auto assign_fingerprints = [&]() {
+      build_throttle_t throttle(budget);
+      fingerprints = std::vector<uint32_t>(array_length, 0);
+
+      const uint32_t prefetch_distance = active_tuning().construction_prefetch_distance.load(std::memory_order_relaxed);
+
+      for (uint32_t i = num_peeled_keys - 1; i < num_peeled_keys; i--) {
+        if ((i % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) [[unlikely]] {
+          throttle.checkpoint();
+        }
+        if ((prefetch_distance != 0) && (i >= prefetch_distance)) {
+          prefetch_fingerprint_slots(reverseOrder[i - prefetch_distance]);
+        }
+
+        const uint64_t hash = reverseOrder[i];
+        assign_fingerprint(hash, values[hm_keys[hash]], reverseH[i]);
+      }
+    };
+
+    if (peeling.numa_node < 0) {
+      assign_fingerprints();
+    } else {
+      // Fingerprints are assigned on the NUMA node, which holds scratch space of the winning attempt, so that random accesses to both stay node local.
+      std::exception_ptr assignment_error = nullptr;
+      {
+        std::jthread assigner([&]() {
+          bff_kv_map_utils::bind_current_thread_to_numa_node(peeling.numa_node);
+
+          try {
+            assign_fingerprints();
+          } catch (...) {
+            assignment_error = std::current_exception();
+          }
+        });
+      }
+
+      if (assignment_error != nullptr) [[unlikely]] {
+        std::rethrow_exception(assignment_error);
+      }
+    }
+
+    if (num_peeled_keys != num_keys_in_kv_map) {
+      for (uint32_t i = 0; i < num_peeled_keys; i++) {
+        hm_keys.erase(reverseOrder[i]);
+      }
+
+      unpeeled_keys->clear();
+      for (const auto& [hash, key_idx] : hm_keys) {
+        unpeeled_keys->emplace_back(hash, values[key_idx]);
+      }
+
+      std::sort(unpeeled_keys->begin(), unpeeled_keys->end());
+    }
+  }
+
+  /**
+   * @brief Validate keys, lay out segments and peel the fuse graph of keys. Sets up everything, except fingerprints, whose assignment is left
+   * to the caller, in reverse peeling order.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param plaintext_modulo The plaintext modulo to use.
+   * @param label The label to use.
+   * @param max_segment_length Upper bound on segment length, must be a power of 2.
+   * @param min_size_factor Lower bound on the ratio of number of fingerprints to number of keys.
+   * @param max_unpeeled_key_count Peeling is considered successful, if at most these many keys are left in the core of the fuse graph.
+   * @param num_speculative_attempts Number of construction attempts to race on parallel threads, attempts are serial if <= 1.
+   * @param budget If not null, peeling yields at chunk boundaries of its loops, to stay within this budget, see `build_budget_t`.
+   * @return The successful peeling attempt, holding the peeling order.
+   */
+  peeling_attempt_t layout_and_peel(std::span<const uint8_t, 32> seed_bytes,
+                                    std::span<const bff_kv_map_utils::bff_key_t> keys,
+                                    const uint64_t plaintext_modulo,
+                                    const uint64_t label,
+                                    const uint32_t max_segment_length,
+                                    const double min_size_factor,
+                                    const size_t max_unpeeled_key_count,
+                                    const size_t num_speculative_attempts,
+                                    const build_budget_t* const budget)
+  {
+    validate_and_lay_out(keys, plaintext_modulo, label, max_segment_length, min_size_factor);
+    return find_peeling(seed_bytes, keys, max_unpeeled_key_count, num_speculative_attempts, budget);
+  }
+
+  // Size of the header of serialized representation i.e. everything but fingerprints.
+  size_t header_num_bytes() const
+  {
+    return sizeof(seed) + sizeof(num_keys_in_kv_map) + sizeof(plaintext_modulo) + sizeof(label) + sizeof(segment_length) + sizeof(segment_count) +
+           sizeof(segment_count_length) + sizeof(array_length);
+  }
+
+  // Serializes the header i.e. everything but fingerprints, to the beginning of given byte array, returning the number of bytes written.
+  size_t serialize_header(std::span<uint8_t> bytes) const
+  {
+    size_t buffer_offset = 0;
+    std::copy_n(seed.begin(), seed.size(), bytes.begin());
+
+    buffer_offset += seed.size();
+    std::copy_n(reinterpret_cast<const uint8_t*>(&num_keys_in_kv_map), sizeof(num_keys_in_kv_map), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(num_keys_in_kv_map);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&plaintext_modulo), sizeof(plaintext_modulo), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(plaintext_modulo);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&label), sizeof(label), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(label);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&segment_length), sizeof(segment_length), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(segment_length);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&segment_count), sizeof(segment_count), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(segment_count);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&segment_count_length), sizeof(segment_count_length), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(segment_count_length);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&array_length), sizeof(array_length), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(array_length);
+
+    return buffer_offset;
+  }
+
+  // Computes the 64-bit hash of a key, which determines its fingerprint slots and mask.
+  uint64_t hash_key(const bff_kv_map_utils::bff_key_t key) const { return bff_kv_map_utils::mix256(key.words, seed); }
+
+  // Recovers the value associated with a key, given its 64-bit hash.
+  uint32_t recover_from_hash(const uint64_t hash) const
+  {
+    const auto [h0, h1, h2] = hash_batch(hash);
+
+    const uint32_t data = fingerprints[h0] + fingerprints[h1] + fingerprints[h2];
+    const uint32_t mask = bff_kv_map_utils::mix(hash, label) % plaintext_modulo;
+
+    return (data + mask) % plaintext_modulo;
+  }
+
+  // Recovers values of many keys, as `recover_batch` does, except that keys, for which `lookup` returns a value given their hash, e.g. because
+  // they're stashed, get that value instead.
+  template<typename lookup_t>
+  bool recover_batch_with_lookup(std::span<const bff_kv_map_utils::bff_key_t> keys, std::span<uint32_t> values, const lookup_t& lookup) const
+  {
+    if (keys.size() != values.size()) [[unlikely]] {
+      return false;
+    }
+
+    const size_t max_batch_size = active_tuning().recover_batch_size.load(std::memory_order_relaxed);
+
+    std::array<uint64_t, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE> hashes;
+    std::array<std::array<uint32_t, 3>, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE> slots;
+
+    for (size_t batch_begin = 0; batch_begin < keys.size(); batch_begin += max_batch_size) {
+      const size_t batch_size = std::min(max_batch_size, keys.size() - batch_begin);
+
+      for (size_t i = 0; i < batch_size; i++) {
+        hashes[i] = hash_key(keys[batch_begin + i]);
+
+        const auto [h0, h1, h2] = hash_batch(hashes[i]);
+        slots[i] = { h0, h1, h2 };
+
+        __builtin_prefetch(fingerprints.data() + h0);
+        __builtin_prefetch(fingerprints.data() + h1);
+        __builtin_prefetch(fingerprints.data() + h2);
+      }
+
+      for (size_t i = 0; i < batch_size; i++) {
+        if (const auto value = lookup(hashes[i]); value.has_value()) [[unlikely]] {
+          values[batch_begin + i] = *value;
+          continue;
+        }
+
+        const uint32_t data = fingerprints[slots[i][0]] + fingerprints[slots[i][1]] + fingerprints[slots[i][2]];
+        const uint32_t mask = bff_kv_map_utils::mix(hashes[i], label) % plaintext_modulo;
+
+        values[batch_begin + i] = (data + mask) % plaintext_modulo;
+      }
+    }
+
+    return true;
+  }
+
+  // Computes the three fingerprint slots of a key, given its 64-bit hash.
+  constexpr std::tuple<uint32_t, uint32_t, uint32_t> hash_batch(const uint64_t hash) const
+  {
+    return bff_kv_map_utils::hash_batch(hash, segment_length, segment_length_mask, segment_count_length);
+  }
+
+private:
+  // Validates keys and plaintext modulo, then lays out segments of the filter, for given number of keys.
+  void validate_and_lay_out(std::span<const bff_kv_map_utils::bff_key_t> keys,
+                            const uint64_t plaintext_modulo,
+                            const uint64_t label,
+                            const uint32_t max_segment_length,
+                            const double min_size_factor)
+  {
+    if (!bff_kv_map_utils::are_all_keys_distinct(keys)) [[unlikely]] {
+      throw std::runtime_error("All keys must be unique.");
+    }
+    if (plaintext_modulo < 256) [[unlikely]] {
+      throw std::runtime_error("Plaintext modulo must be >= 256.");
+    }
+
+    num_keys_in_kv_map = keys.size();
+    constexpr uint32_t arity = 3;
+    segment_length = num_keys_in_kv_map == 0 ? 4 : bff_kv_map_utils::calculate_segment_length(arity, num_keys_in_kv_map);
+    if (segment_length > max_segment_length) {
+      segment_length = max_segment_length;
+    }
+
+    segment_length_mask = segment_length - 1;
+
+    const double sizeFactor = num_keys_in_kv_map <= 1 ? 0 : std::max(min_size_factor, bff_kv_map_utils::calculate_size_factor(arity, num_keys_in_kv_map));
+    const uint32_t capacity = num_keys_in_kv_map <= 1 ? 0 : static_cast<uint32_t>(round(static_cast<double>(num_keys_in_kv_map) * sizeFactor));
+    const uint32_t initSegmentCount = (capacity + segment_length - 1) / segment_length - (arity - 1);
+
+    array_length = (initSegmentCount + arity - 1) * segment_length;
+    segment_count = (array_length + segment_length - 1) / segment_length;
+
+    if (segment_count <= arity - 1) {
+      segment_count = 1;
+    } else {
+      segment_count = segment_count - (arity - 1);
+    }
+
+    array_length = (segment_count + arity - 1) * segment_length;
+    segment_count_length = segment_count * segment_length;
+
+    this->plaintext_modulo = plaintext_modulo;
+    this->label = label;
+  }
+
+  // Attempts peeling, under a different tweak of the seed each time, until one attempt succeeds, within given build budget, if any. Sets the seed of
+  // the filter to that of the winning attempt and returns it. Within a budget, the number of speculative attempts is an upper bound on threads, so the
+  // first attempt, which mostly succeeds, runs alone on the calling thread, and later attempts are raced only once it has failed.
+  peeling_attempt_t find_peeling(std::span<const uint8_t, 32> seed_bytes,
+                                 std::span<const bff_kv_map_utils::bff_key_t> keys,
+                                 const size_t max_unpeeled_key_count,
+                                 const size_t num_speculative_attempts,
+                                 const build_budget_t* const budget)
+  {
+    const size_t num_serial_attempts = (num_speculative_attempts <= 1) ? BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT : ((budget != nullptr) ? 1 : 0);
+
+    peeling_attempt_t peeling{};
+    build_throttle_t throttle(budget);
+    bool is_peeled = false;
+
+    size_t attempt = 0;
+    for (; !is_peeled && (attempt < num_serial_attempts); attempt++) {
+      is_peeled = peel(bff_kv_map_utils::derive_seed(seed_bytes, attempt), keys, max_unpeeled_key_count, attempt, nullptr, throttle, peeling);
+    }
+
+    if (!is_peeled) {
+      if (attempt >= BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT) [[unlikely]] {
+        throw std::runtime_error("Failed to construct Binary Fuse Filter for input Key-Value Map.");
+      }
+
+      // Scratch space of the failed serial attempt is released, before raced attempts allocate their own.
+      peeling = peeling_attempt_t{};
+      peeling = peel_speculatively(seed_bytes, keys, max_unpeeled_key_count, attempt, num_speculative_attempts, budget);
+    }
+
+    this->seed = peeling.seed;
+    return peeling;
+  }
+
+  // Prefetches, for writing, the three fingerprint slots a hash maps to.
+  void prefetch_fingerprint_slots(const uint64_t hash) const
+  {
+    const auto [h0, h1, h2] = hash_batch(hash);
+
+    __builtin_prefetch(fingerprints.data() + h0, 1);
+    __builtin_prefetch(fingerprints.data() + h1, 1);
+    __builtin_prefetch(fingerprints.data() + h2, 1);
+  }
+
+  // Assigns the fingerprint at the slot, a peeled key was found alone in, s.t. the three fingerprints of the key sum up to its masked value.
+  void assign_fingerprint(const uint64_t hash, const uint32_t value, const uint8_t found)
+  {
+    const auto [h0, h1, h2] = hash_batch(hash);
+    const std::array<uint32_t, 5> h012{ h0, h1, h2, h0, h1 };
+
+    const uint32_t entry = ((value % plaintext_modulo) - fingerprints[h012[found + 1]] - fingerprints[h012[found + 2]]) % plaintext_modulo;
+    const uint32_t mask = bff_kv_map_utils::mix(hash, label) % plaintext_modulo;
+
+    fingerprints[h012[found]] = (entry - mask) % plaintext_modulo;
+  }
+
+  /**
+   * @brief Attempt to peel the fuse graph of keys, hashed under the given seed. Segment layout must already be set.
+   *
+   * @param attempt_seed The seed to hash keys with.
+   * @param keys The keys of the Key-Value Map.
+   * @param max_unpeeled_key_count Peeling is considered successful, if at most these many keys are left in the core of the fuse graph.
+   * @param attempt Index of this attempt.
+   * @param lowest_peeled_attempt If not null, this attempt is abandoned as soon as it's no longer below this index, i.e. once an attempt with lower
+   * index has peeled, or it's set to 0, when another attempt has failed with an exception.
+   * @param throttle Keeps peeling within the build budget, if any, by yielding at chunk boundaries of its loops.
+   * @param peeling Scratch space, which holds the peeling order, if successful.
+   * @return True if peeling was successful, false otherwise.
+   */
+  bool peel(std::span<const uint8_t, 32> attempt_seed,
+            std::span<const bff_kv_map_utils::bff_key_t> keys,
+            const size_t max_unpeeled_key_count,
+            const size_t attempt,
+            const std::atomic<size_t>* const lowest_peeled_attempt,
+            build_throttle_t& throttle,
+            peeling_attempt_t& peeling) const
+  {
+    const auto is_cancelled = [&]() {
+      return (lowest_peeled_attempt != nullptr) && (lowest_peeled_attempt->load(std::memory_order_relaxed) <= attempt);
+    };
+    // Called at chunk boundaries of loops, yielding to stay within the build budget, before checking for cancellation.
+    const auto yield_and_check_cancellation = [&]() {
+      throttle.checkpoint();
+      return is_cancelled();
+    };
+
+    peeling.attempt = attempt;
+    peeling.is_peeled = false;
+    std::copy(attempt_seed.begin(), attempt_seed.end(), peeling.seed.begin());
+
+    auto& reverseOrder = peeling.reverseOrder;
+    auto& reverseH = peeling.reverseH;
+    auto& alone = peeling.alone;
+    auto& t2count = peeling.t2count;
+    auto& t2hash = peeling.t2hash;
+    auto& startPos = peeling.startPos;
+    auto& hm_keys = peeling.hm_keys;
+
+    reverseOrder.resize(num_keys_in_kv_map + 1);
+    reverseH.resize(num_keys_in_kv_map);
+    alone.resize(array_length);
+    t2count.resize(array_length);
+    t2hash.resize(array_length);
+
+    const bool non_temporal = throttle.use_non_temporal_stores();
+    bff_kv_map_utils::zero_fill(std::span(reverseOrder), non_temporal);
+    bff_kv_map_utils::zero_fill(std::span(reverseH), non_temporal);
+    bff_kv_map_utils::zero_fill(std::span(alone), non_temporal);
+    bff_kv_map_utils::zero_fill(std::span(t2count), non_temporal);
+    bff_kv_map_utils::zero_fill(std::span(t2hash), non_temporal);
+    hm_keys.clear();
+
+    uint32_t block_bits = 1;
+    while ((1U << block_bits) < segment_count) {
+      block_bits++;
+    }
+
+    const uint32_t block_size = 1U << block_bits;
+    startPos.assign(block_size, 0);
+
+    std::array<uint32_t, 5> h012{};
+    reverseOrder[num_keys_in_kv_map] = 1;
+
+    for (uint32_t i = 0; i < block_size; i++) {
+      startPos[i] = static_cast<uint32_t>((static_cast<uint64_t>(i) * static_cast<uint64_t>(num_keys_in_kv_map)) >> block_bits);
+    }
+
+    uint64_t maskblock = block_size - 1;
+    for (uint32_t i = 0; i < num_keys_in_kv_map; i++) {
+      if (((i % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) && yield_and_check_cancellation()) [[unlikely]] {
+        return false;
+      }
+
+      const uint64_t hash = bff_kv_map_utils::mix256(keys[i].words, attempt_seed);
+
+      uint64_t segment_index = hash >> (64 - block_bits);
+      while (reverseOrder[startPos[segment_index]] != 0) {
+        segment_index++;
+        segment_index &= maskblock;
+      }
+
+      reverseOrder[startPos[segment_index]] = hash;
+      startPos[segment_index]++;
+
+      hm_keys[hash] = i;
+    }
+
+    // Overflow of any slot's count rejects the seed, whichever order keys are counted in.
+    bool error = false;
+    for (uint32_t i = 0; i < num_keys_in_kv_map; i++) {
+      if (((i % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) && yield_and_check_cancellation()) [[unlikely]] {
+        return false;
+      }
+
+      const uint64_t hash = reverseOrder[i];
+      const auto [h0, h1, h2] = hash_batch(hash);
+
+      t2count[h0] += 4;
+      t2hash[h0] ^= hash;
+
+      t2count[h1] += 4;
+      t2count[h1] ^= 1U;
+      t2hash[h1] ^= hash;
+
+      t2count[h2] += 4;
+      t2hash[h2] ^= hash;
+      t2count[h2] ^= 2U;
+
+      error |= (t2count[h0] < 4) || (t2count[h1] < 4) || (t2count[h2] < 4);
+    }
+
+    if (error || is_cancelled()) {
+      return false;
+    }
+
+    uint32_t Qsize = 0;
+    for (uint32_t i = 0; i < array_length; i++) {
+      if ((i % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) [[unlikely]] {
+        throttle.checkpoint();
+      }
+
+      alone[Qsize] = i;
+      Qsize += ((t2count[i] >> 2U) == 1) ? 1U : 0U;
+    }
+
+    uint32_t stacksize = 0;
+    while (Qsize > 0) {
+      Qsize--;
+      const uint32_t index = alone[Qsize];
+
+      if ((t2count[index] >> 2U) == 1) {
+        const uint64_t hash = t2hash[index];
+
+        const uint8_t found = t2count[index] & 3U;
+        reverseH[stacksize] = found;
+        reverseOrder[stacksize] = hash;
+        stacksize++;
+
+        if (((stacksize % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) && yield_and_check_cancellation()) [[unlikely]] {
+          return false;
+        }
+
+        const auto [h0, h1, h2] = hash_batch(hash);
+
+        h012[1] = h1;
+        h012[2] = h2;
+        h012[3] = h0;
+        h012[4] = h012[1];
+
+        const uint32_t other_index1 = h012[found + 1];
+        alone[Qsize] = other_index1;
+        Qsize += ((t2count[other_index1] >> 2U) == 2 ? 1U : 0U);
+
+        t2count[other_index1] -= 4;
+        t2count[other_index1] ^= bff_kv_map_utils::mod3(found + 1);
+        t2hash[other_index1] ^= hash;
+
+        const uint32_t other_index2 = h012[found + 2];
+        alone[Qsize] = other_index2;
+        Qsize += ((t2count[other_index2] >> 2U) == 2 ? 1U : 0U);
+
+        t2count[other_index2] -= 4;
+        t2count[other_index2] ^= bff_kv_map_utils::mod3(found + 2);
+        t2hash[other_index2] ^= hash;
+      }
+    }
+
+    peeling.num_peeled_keys = stacksize;
+    peeling.is_peeled = (num_keys_in_kv_map - stacksize) <= max_unpeeled_key_count;
+
+    return peeling.is_peeled;
+  }
+
+  /**
+   * @brief Race attempts at peeling the fuse graph, each under a different seed tweak, on parallel threads. Attempts are claimed in order of their
+   * index, and an attempt is abandoned only once some attempt with lower index has peeled, so the lowest indexed successful attempt wins, exactly as
+   * it would have, when attempted serially.
+   * When the calling thread may run on multiple NUMA nodes, workers are bound round-robin to those nodes, so that scratch space of each attempt is
+   * local to the thread peeling it. Scratch space of an attempt is never split across nodes, and serial attempts aren't bound at all.
+   * If an attempt throws, e.g. failing to allocate its scratch space, all other attempts are abandoned, and the first exception is rethrown, once all
+   * workers have joined.
+   *
+   * @param seed_bytes The seed bytes, which seed of each attempt is derived from.
+   * @param keys The keys of the Key-Value Map.
+   * @param max_unpeeled_key_count Peeling is considered successful, if at most these many keys are left in the core of the fuse graph.
+   * @param first_attempt Index of the first attempt to run, all lower indexed attempts have already failed.
+   * @param num_speculative_attempts Number of attempts to run in parallel.
+   * @param budget If not null, each worker yields at chunk boundaries of its loops, to stay within this budget, see `build_budget_t`.
+   * @return The winning attempt.
+   */
+  peeling_attempt_t peel_speculatively(std::span<const uint8_t, 32> seed_bytes,
+                                       std::span<const bff_kv_map_utils::bff_key_t> keys,
+                                       const size_t max_unpeeled_key_count,
+                                       const size_t first_attempt,
+                                       const size_t num_speculative_attempts,
+                                       const build_budget_t* const budget) const
+  {
+    const size_t num_workers = std::min(num_speculative_attempts, BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT - first_attempt);
+    const auto numa_nodes = bff_kv_map_utils::numa_nodes_of_current_thread();
+
+    std::vector<peeling_attempt_t> peelings(num_workers);
+    std::atomic<size_t> next_attempt{ first_attempt };
+    std::atomic<size_t> lowest_peeled_attempt{ BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT };
+
+    std::exception_ptr peeling_error = nullptr;
+    std::atomic<bool> has_failed{ false };
+
+    {
+      std::vector<std::jthread> workers;
+      workers.reserve(num_workers);
+
+      for (size_t worker_idx = 0; worker_idx < num_workers; worker_idx++) {
+        workers.emplace_back([&, worker_idx]() {
+          auto& peeling = peelings[worker_idx];
+          build_throttle_t throttle(budget);
+
+          try {
+            // Workers are spread across NUMA nodes, each one binding itself before first touching its scratch space, inside `peel`.
+            if (numa_nodes.size() > 1) {
+              peeling.numa_node = numa_nodes[worker_idx % numa_nodes.size()];
+              bff_kv_map_utils::bind_current_thread_to_numa_node(peeling.numa_node);
+            }
+
+            while (true) {
+              const size_t attempt = next_attempt.fetch_add(1, std::memory_order_relaxed);
+              if (attempt >= lowest_peeled_attempt.load(std::memory_order_relaxed)) {
+                break;
+              }
+
+              if (peel(bff_kv_map_utils::derive_seed(seed_bytes, attempt), keys, max_unpeeled_key_count, attempt, &lowest_peeled_attempt, throttle, peeling)) {
+                size_t lowest = lowest_peeled_attempt.load(std::memory_order_relaxed);
+                while ((attempt < lowest) && !lowest_peeled_attempt.compare_exchange_weak(lowest, attempt, std::memory_order_relaxed)) {
+                }
+
+                break;
+              }
+            }
+          } catch (...) {
+            // Only the first failing worker publishes its exception, which is read after join. Setting the lowest peeled attempt to 0 abandons all
+            // other attempts.
+            if (!has_failed.exchange(true, std::memory_order_relaxed)) {
+              peeling_error = std::current_exception();
+            }
+            lowest_peeled_attempt.store(0, std::memory_order_relaxed);
+          }
+        });
+      }
+    }
+
+    if (peeling_error != nullptr) [[unlikely]] {
+      std::rethrow_exception(peeling_error);
+    }
+
+    const size_t winning_attempt = lowest_peeled_attempt.load(std::memory_order_relaxed);
+    if (winning_attempt >= BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT) [[unlikely]] {
+      throw std::runtime_error("Failed to construct Binary Fuse Filter for input Key-Value Map.");
+    }
+
+    const auto it =
+      std::find_if(peelings.begin(), peelings.end(), [&](const auto& peeling) { return peeling.is_peeled && (peeling.attempt == winning_attempt); });
+    return std::move(*it);
+  }
+
+  // Scratch space of the compact construction path. Each slot tracks XOR of 16 -bit indices of keys hashed into it, instead of XOR of their 64 -bit
+  // hashes, while hashes are looked up by key index. So a peeled key directly yields its index, making the map from hash to key index redundant.
+  // Buffers are kept per thread and reused across builds, so building many small filters doesn't touch the allocator. Slot counts are zeroed, as on
+  // the regular path, with non-temporal stores, when budgeted so.
+  struct small_peeling_scratch_t
+  {
+    std::vector<uint64_t> hashes;
+    bff_kv_map_utils::scratch_vector_t<uint8_t> t2count;
+    bff_kv_map_utils::scratch_vector_t<uint16_t> t2key;
+    std::vector<uint32_t> alone;
+    std::vector<uint16_t> reverseOrder;
+    std::vector<uint8_t> reverseH;
+  };
+
+  static small_peeling_scratch_t& small_peeling_scratch()
+  {
+    thread_local small_peeling_scratch_t scratch;
+    return scratch;
+  }
+
+  /**
+   * @brief Build the filter on the compact path. Segment layout must already be set, for at most `BFF_FOR_KV_MAP_SMALL_MAX_KEY_COUNT` keys, so that
+   * key indices fit in 16 -bit. A seed is rejected on exactly the same slot count overflows, and peeling proceeds in the very same order as on the
+   * regular path, so the resulting filter is the same.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param values The values of the Key-Value Map s.t. value ∈ [0,plaintext_modulo)
+   * @param throttle Keeps construction within the build budget, if any, by yielding at chunk boundaries of its loops.
+   */
+  void build_small(std::span<const uint8_t, 32> seed_bytes,
+                   std::span<const bff_kv_map_utils::bff_key_t> keys,
+                   std::span<const uint32_t> values,
+                   build_throttle_t& throttle)
+  {
+    auto& scratch = small_peeling_scratch();
+    bool is_peeled = false;
+
+    for (size_t attempt = 0; !is_peeled; attempt++) {
+      if ((attempt + 1) > BFF_FOR_KV_MAP_MAX_CREATE_ATTEMPT_COUNT) [[unlikely]] {
+        throw std::runtime_error("Failed to construct Binary Fuse Filter for input Key-Value Map.");
+      }
+
+      this->seed = bff_kv_map_utils::derive_seed(seed_bytes, attempt);
+      is_peeled = peel_small(keys, throttle, scratch);
+    }
+
+    fingerprints = std::vector<uint32_t>(array_length, 0);
+
+    for (uint32_t i = num_keys_in_kv_map - 1; i < num_keys_in_kv_map; i--) {
+      if ((i % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) [[unlikely]] {
+        throttle.checkpoint();
+      }
+
+      const uint16_t key_idx = scratch.reverseOrder[i];
+      assign_fingerprint(scratch.hashes[key_idx], values[key_idx], scratch.reverseH[i]);
+    }
+  }
+
+  // Attempts to peel the fuse graph of keys, hashed under the current seed of the filter, on the compact path, yielding at chunk boundaries of its
+  // loops, to stay within the build budget, if any. Returns true if all keys got peeled.
+  bool peel_small(std::span<const bff_kv_map_utils::bff_key_t> keys, build_throttle_t& throttle, small_peeling_scratch_t& scratch) const
+  {
+    auto& hashes = scratch.hashes;
+    auto& t2count = scratch.t2count;
+    auto& t2key = scratch.t2key;
+    auto& alone = scratch.alone;
+    auto& reverseOrder = scratch.reverseOrder;
+    auto& reverseH = scratch.reverseH;
+
+    hashes.resize(num_keys_in_kv_map);
+    t2count.resize(array_length);
+    t2key.resize(array_length);
+    alone.resize(array_length);
+    reverseOrder.resize(num_keys_in_kv_map);
+    reverseH.resize(num_keys_in_kv_map);
+
+    const bool non_temporal = throttle.use_non_temporal_stores();
+    bff_kv_map_utils::zero_fill(std::span(t2count), non_temporal);
+    bff_kv_map_utils::zero_fill(std::span(t2key), non_temporal);
+
+    bool error = false;
+    for (uint32_t i = 0; i < num_keys_in_kv_map; i++) {
+      if ((i % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) [[unlikely]] {
+        throttle.checkpoint();
+      }
+
+      const uint64_t hash = hash_key(keys[i]);
+      const auto key_idx = static_cast<uint16_t>(i);
+      const auto [h0, h1, h2] = hash_batch(hash);
+
+      hashes[i] = hash;
+
+      t2count[h0] += 4;
+      t2key[h0] ^= key_idx;
+
+      t2count[h1] += 4;
+      t2count[h1] ^= 1U;
+      t2key[h1] ^= key_idx;
+
+      t2count[h2] += 4;
+      t2key[h2] ^= key_idx;
+      t2count[h2] ^= 2U;
+
+      error |= (t2count[h0] < 4) || (t2count[h1] < 4) || (t2count[h2] < 4);
+    }
+
+    if (error) {
+      return false;
+    }
+
+    uint32_t Qsize = 0;
+    for (uint32_t i = 0; i < array_length; i++) {
+      if ((i % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) [[unlikely]] {
+        throttle.checkpoint();
+      }
+
+      alone[Qsize] = i;
+      Qsize += ((t2count[i] >> 2U) == 1) ? 1U : 0U;
+    }
+
+    std::array<uint32_t, 5> h012{};
+    uint32_t stacksize = 0;
+
+    while (Qsize > 0) {
+      Qsize--;
+      const uint32_t index = alone[Qsize];
+
+      if ((t2count[index] >> 2U) == 1) {
+        const uint16_t key_idx = t2key[index];
+        const uint64_t hash = hashes[key_idx];
+
+        const uint8_t found = t2count[index] & 3U;
+        reverseH[stacksize] = found;
+        reverseOrder[stacksize] = key_idx;
+        stacksize++;
+
+        if ((stacksize % BFF_FOR_KV_MAP_CANCELLATION_CHECK_INTERVAL) == 0) [[unlikely]] {
+          throttle.checkpoint();
+        }
+
+        const auto [h0, h1, h2] = hash_batch(hash);
+
+        h012[1] = h1;
+        h012[2] = h2;
+        h012[3] = h0;
+        h012[4] = h012[1];
+
+        const uint32_t other_index1 = h012[found + 1];
+        alone[Qsize] = other_index1;
+        Qsize += ((t2count[other_index1] >> 2U) == 2 ? 1U : 0U);
+
+        t2count[other_index1] -= 4;
+        t2count[other_index1] ^= bff_kv_map_utils::mod3(found + 1);
+        t2key[other_index1] ^= key_idx;
+
+        const uint32_t other_index2 = h012[found + 2];
+        alone[Qsize] = other_index2;
+        Qsize += ((t2count[other_index2] >> 2U) == 2 ? 1U : 0U);
+
+        t2count[other_index2] -= 4;
+        t2count[other_index2] ^= bff_kv_map_utils::mod3(found + 2);
+        t2key[other_index2] ^= key_idx;
+      }
+    }
+
+    return stacksize == num_keys_in_kv_map;
   }
 };
 
@@ -0,0 +1,223 @@
+#pragma once
+#include "filter_for_kv_map.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Handle of a filter in a filter set is (slab index << 16) | (offset of filter in its slab, in cache lines). So a slab spans 2^16 cache lines i.e. 4MB.
+constexpr uint32_t BFF_FOR_KV_MAP_SET_SLAB_OFFSET_BIT_WIDTH = 16;
+constexpr size_t BFF_FOR_KV_MAP_SET_SLAB_NUM_CACHE_LINES = 1UL << BFF_FOR_KV_MAP_SET_SLAB_OFFSET_BIT_WIDTH;
+constexpr size_t BFF_FOR_KV_MAP_SET_MAX_SLAB_COUNT = 1UL << (32 - BFF_FOR_KV_MAP_SET_SLAB_OFFSET_BIT_WIDTH);
+
+// Set of many, typically small, Binary Fuse Filters for Key-Value Maps, identified by compact 32 -bit handles.
+// Each filter is laid out as a cache line sized header, immediately followed by its fingerprints, and filters are packed back to back in large slabs.
+// So the set does one heap allocation per slab, instead of one per filter, and recovering a value computes the address of the filter from its handle,
+// instead of loading a pointer to fingerprints. Filters spanning more than a slab get a dedicated slab of their own.
+struct bff_for_kv_map_set_t
+{
+private:
+  struct alignas(64) cache_line_t
+  {
+    std::byte bytes[64];
+  };
+
+  // Everything needed to recover a value from a filter, except its fingerprints, which follow it.
+  struct alignas(64) filter_header_t
+  {
+    std::array<uint8_t, 32> seed{};
+    uint64_t plaintext_modulo = 0;
+    uint64_t label = 0;
+    uint32_t segment_length = 0;
+    uint32_t segment_count_length = 0;
+    uint32_t array_length = 0;
+  };
+  static_assert(sizeof(filter_header_t) == sizeof(cache_line_t));
+
+  std::vector<std::unique_ptr<cache_line_t[]>> slabs;
+  // Number of cache lines carved out of each slab, which hold copies of seeds and fingerprints of filters, and so are wiped on destruction.
+  std::vector<size_t> slab_num_used_cache_lines;
+  size_t current_slab_idx = 0;
+  size_t num_cache_lines_in_current_slab = BFF_FOR_KV_MAP_SET_SLAB_NUM_CACHE_LINES;
+  size_t num_filters = 0;
+
+public:
+  bff_for_kv_map_set_t() = default;
+
+  bff_for_kv_map_set_t(const bff_for_kv_map_set_t&) = delete;
+  bff_for_kv_map_set_t& operator=(const bff_for_kv_map_set_t&) = delete;
+
+  /**
+   * @brief Move construct a filter set, taking over slabs of the source, without copying them. The source is left as an empty set, while handles
+   * of its filters stay valid with this set.
+   *
+   * @param other The filter set to move from.
+   */
+  bff_for_kv_map_set_t(bff_for_kv_map_set_t&& other) noexcept { swap(other); }
+
+  /**
+   * @brief Move assign a filter set, taking over slabs of the source, without copying them. Slabs held before assignment are wiped, and the source
+   * is left as an empty set.
+   *
+   * @param other The filter set to move from.
+   * @return This filter set.
+   */
+  bff_for_kv_map_set_t& operator=(bff_for_kv_map_set_t&& other) noexcept
+  {
+    bff_for_kv_map_set_t(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  /**
+   * @brief Destroy the filter set, while zeroing out headers and fingerprints of all filters, before memory of their slabs is freed, same as
+   * `bff_for_kv_map_t` wipes its own.
+   */
+  ~bff_for_kv_map_set_t()
+  {
+    for (size_t slab_idx = 0; slab_idx < slabs.size(); slab_idx++) {
+      bff_kv_map_utils::secure_wipe(std::span(slabs[slab_idx].get(), slab_num_used_cache_lines[slab_idx]));
+    }
+  }
+
+  /**
+   * @brief Swap two filter sets, without copying their slabs.
+   *
+   * @param other The filter set to swap with.
+   */
+  void swap(bff_for_kv_map_set_t& other) noexcept
+  {
+    slabs.swap(other.slabs);
+    slab_num_used_cache_lines.swap(other.slab_num_used_cache_lines);
+    std::swap(current_slab_idx, other.current_slab_idx);
+    std::swap(num_cache_lines_in_current_slab, other.num_cache_lines_in_current_slab);
+    std::swap(num_filters, other.num_filters);
+  }
+
+  friend void swap(bff_for_kv_map_set_t& lhs, bff_for_kv_map_set_t& rhs) noexcept { lhs.swap(rhs); }
+
+  /**
+   * @brief Construct a Binary Fuse Filter for Key-Value Map and add it to the set.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param values The values of the Key-Value Map s.t. value ∈ [0,plaintext_modulo)
+   * @param plaintext_modulo The plaintext modulo to use.
+   * @param label The label to use.
+   * @return Handle of the added filter.
+   */
+  uint32_t add(std::span<const uint8_t, 32> seed_bytes,
+               std::span<const bff_kv_map_utils::bff_key_t> keys,
+               std::span<const uint32_t> values,
+               const uint64_t plaintext_modulo,
+               const uint64_t label)
+  {
+    return add(bff_for_kv_map_t(seed_bytes, keys, values, plaintext_modulo, label));
+  }
+
+  /**
+   * @brief Copy an already constructed Binary Fuse Filter for Key-Value Map into the set.
+   *
+   * @param filter The filter to add.
+   * @return Handle of the added filter.
+   */
+  uint32_t add(const bff_for_kv_map_t& filter)
+  {
+    const size_t num_cache_lines = 1 + ((filter.array_length * sizeof(uint32_t)) + sizeof(cache_line_t) - 1) / sizeof(cache_line_t);
+    const uint32_t handle = allocate(num_cache_lines);
+
+    cache_line_t* const record = cache_lines_of(handle);
+
+    auto* const header = new (record) filter_header_t{};
+    header->seed = filter.seed;
+    header->plaintext_modulo = filter.plaintext_modulo;
+    header->label = filter.label;
+    header->segment_length = filter.segment_length;
+    header->segment_count_length = filter.segment_count_length;
+    header->array_length = filter.array_length;
+
+    auto* const fingerprints = new (record + 1) uint32_t[filter.array_length];
+    std::copy_n(filter.fingerprints.begin(), filter.array_length, fingerprints);
+
+    num_filters++;
+    return handle;
+  }
+
+  /**
+   * @brief Get the number of filters in the set.
+   *
+   * @return The number of filters.
+   */
+  size_t size() const { return num_filters; }
+
+  /**
+   * @brief Recover the value associated with a given key, from the filter identified by given handle.
+   *
+   * @param handle Handle of the filter, as returned by `add`. Must be valid.
+   * @param key The key to query.
+   * @return The value associated with the key.
+   */
+  uint32_t recover(const uint32_t handle, const bff_kv_map_utils::bff_key_t key) const
+  {
+    const cache_line_t* const record = cache_lines_of(handle);
+
+    const auto* const header = std::launder(reinterpret_cast<const filter_header_t*>(record));
+    const auto* const fingerprints = std::launder(reinterpret_cast<const uint32_t*>(record + 1));
+
+    const uint64_t hash = bff_kv_map_utils::mix256(key.words, header->seed);
+    const auto [h0, h1, h2] = bff_kv_map_utils::hash_batch(hash, header->segment_length, header->segment_length - 1, header->segment_count_length);
+
+    const uint32_t data = fingerprints[h0] + fingerprints[h1] + fingerprints[h2];
+    const uint32_t mask = bff_kv_map_utils::mix(hash, header->label) % header->plaintext_modulo;
+
+    return (data + mask) % header->plaintext_modulo;
+  }
+
+private:
+  cache_line_t* cache_lines_of(const uint32_t handle) const
+  {
+    return slabs[handle >> BFF_FOR_KV_MAP_SET_SLAB_OFFSET_BIT_WIDTH].get() + (handle & (BFF_FOR_KV_MAP_SET_SLAB_NUM_CACHE_LINES - 1));
+  }
+
+  // Carves given number of cache lines out of the current slab, or a fresh one, if the current slab doesn't have enough space left. Returns handle of
+  // the first carved cache line.
+  uint32_t allocate(const size_t num_cache_lines)
+  {
+    const bool is_dedicated = num_cache_lines > BFF_FOR_KV_MAP_SET_SLAB_NUM_CACHE_LINES;
+    const bool has_space =
+      (current_slab_idx < slabs.size()) && ((BFF_FOR_KV_MAP_SET_SLAB_NUM_CACHE_LINES - num_cache_lines_in_current_slab) >= num_cache_lines);
+
+    if (is_dedicated || !has_space) {
+      if (slabs.size() == BFF_FOR_KV_MAP_SET_MAX_SLAB_COUNT) [[unlikely]] {
+        throw std::runtime_error("Filter set is full.");
+      }
+
+      slab_num_used_cache_lines.reserve(slabs.size() + 1);
+      slabs.push_back(std::make_unique_for_overwrite<cache_line_t[]>(std::max(num_cache_lines, BFF_FOR_KV_MAP_SET_SLAB_NUM_CACHE_LINES)));
+      slab_num_used_cache_lines.push_back(is_dedicated ? num_cache_lines : 0);
+
+      if (is_dedicated) {
+        return static_cast<uint32_t>((slabs.size() - 1) << BFF_FOR_KV_MAP_SET_SLAB_OFFSET_BIT_WIDTH);
+      }
+
+      current_slab_idx = slabs.size() - 1;
+      num_cache_lines_in_current_slab = 0;
+    }
+
+    const auto handle = static_cast<uint32_t>((current_slab_idx << BFF_FOR_KV_MAP_SET_SLAB_OFFSET_BIT_WIDTH) | num_cache_lines_in_current_slab);
+    num_cache_lines_in_current_slab += num_cache_lines;
+    slab_num_used_cache_lines[current_slab_idx] = num_cache_lines_in_current_slab;
+
+    return handle;
+  }
+};
+
+}
@@ -0,0 +1,185 @@
+#pragma once
+#include "filter_for_kv_map.hpp"
+#include "stash.hpp"
+#include "utils.hpp"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Segment length cap of the cache- and TLB-local variant. Three probes of a key fall within three consecutive segments i.e. a window of 3 * 256 * 4 = 3KB,
+// which touches at most two 4KB pages, irrespective of the number of keys.
+constexpr uint32_t BFF_FOR_KV_MAP_LOCAL_MAX_SEGMENT_LENGTH = 256;
+// Short segments peel reliably only when there are more fingerprint slots per key.
+constexpr double BFF_FOR_KV_MAP_LOCAL_MIN_SIZE_FACTOR = 1.25;
+
+// Cache- and TLB-local variant of Binary Fuse Filter for Key-Value Maps, trading some space for fewer cache and TLB misses when recovering values.
+// With short segments, a few keys end up sharing all of their three slots, which makes them unpeelable. Those are kept in a small sorted stash,
+// which is looked up before probing fingerprints. It's not a `bff_for_kv_map_t`, as members of the latter, which don't know about the stash, would
+// return wrong values for stashed keys. So the `bff-modp` layout, sub-filter extraction and fingerprints for PIR aren't offered.
+struct bff_for_kv_map_local_t : protected bff_for_kv_map_t
+{
+private:
+  kv_stash_t stash;
+
+public:
+  bff_for_kv_map_local_t() = default;
+
+  /**
+   * @brief Construct a cache- and TLB-local Binary Fuse Filter for Key-Value Map.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param values The values of the Key-Value Map s.t. value ∈ [0,plaintext_modulo)
+   * @param plaintext_modulo The plaintext modulo to use.
+   * @param label The label to use.
+   */
+  explicit bff_for_kv_map_local_t(std::span<const uint8_t, 32> seed_bytes,
+                                  std::span<const bff_kv_map_utils::bff_key_t> keys,
+                                  std::span<const uint32_t> values,
+                                  const uint64_t plaintext_modulo,
+                                  const uint64_t label)
+  {
+    std::vector<std::pair<uint64_t, uint32_t>> unpeeled_keys;
+    build(seed_bytes,
+          keys,
+          values,
+          plaintext_modulo,
+          label,
+          BFF_FOR_KV_MAP_LOCAL_MAX_SEGMENT_LENGTH,
+          BFF_FOR_KV_MAP_LOCAL_MIN_SIZE_FACTOR,
+          &unpeeled_keys,
+          1,
+          nullptr);
+
+    stash = kv_stash_t(std::move(unpeeled_keys));
+  }
+
+  /**
+   * @brief Construct a cache- and TLB-local Binary Fuse Filter for Key-Value Map from serialized bytes.
+   *
+   * @param bytes The serialized bytes representation of a cache- and TLB-local Binary Fuse Filter.
+   */
+  explicit bff_for_kv_map_local_t(std::span<const uint8_t> bytes)
+    : bff_for_kv_map_t(bytes)
+    , stash(bytes.subspan(bff_for_kv_map_t::serialized_num_bytes()))
+  {
+  }
+
+  using bff_for_kv_map_t::get_seed;
+
+  /**
+   * @brief Get the number of bits per entry, counting both fingerprints and the stash.
+   *
+   * @return The number of bits per entry.
+   */
+  size_t bits_per_entry() const
+  {
+    const size_t num_fingerprint_bits = fingerprints.size() * static_cast<size_t>(std::log2(plaintext_modulo));
+    const size_t num_stash_bits = stash.serialized_num_bytes() * 8;
+
+    return (num_fingerprint_bits + num_stash_bits) / static_cast<size_t>(num_keys_in_kv_map);
+  }
+
+  /**
+   * @brief Get the number of keys kept in the stash, because they couldn't be peeled.
+   *
+   * @return The number of stashed keys.
+   */
+  size_t stash_size() const { return stash.size(); }
+
+  /**
+   * @brief Swap two cache- and TLB-local Binary Fuse Filters for Key-Value Map, along with their stashes, without copying their fingerprints.
+   *
+   * @param other The filter to swap with.
+   */
+  void swap(bff_for_kv_map_local_t& other) noexcept
+  {
+    bff_for_kv_map_t::swap(other);
+    stash.swap(other.stash);
+  }
+
+  friend void swap(bff_for_kv_map_local_t& lhs, bff_for_kv_map_local_t& rhs) noexcept { lhs.swap(rhs); }
+
+  /**
+   * @brief Get the size of the serialized representation of the cache- and TLB-local Binary Fuse Filter in bytes.
+   *
+   * @return The size in bytes.
+   */
+  size_t serialized_num_bytes() const
+  {
+    return bff_for_kv_map_t::serialized_num_bytes() + stash.serialized_num_bytes();
+  }
+
+  /**
+   * @brief Serialize the cache- and TLB-local Binary Fuse Filter to a byte array.
+   *
+   * @param bytes The byte array to serialize to.
+   * @return True if serialization was successful, false otherwise.
+   */
+  bool serialize(std::span<uint8_t> bytes) const
+  {
+    if (bytes.size() != serialized_num_bytes()) [[unlikely]] {
+      return false;
+    }
+
+    size_t buffer_offset = bff_for_kv_map_t::serialized_num_bytes();
+    if (!bff_for_kv_map_t::serialize(bytes.first(buffer_offset))) [[unlikely]] {
+      return false;
+    }
+
+    return stash.serialize(bytes.subspan(buffer_offset));
+  }
+
+  /**
+   * @brief Recover the value associated with a given key.
+   *
+   * @param key The key to query.
+   * @return The value associated with the key.
+   */
+  uint32_t recover(const bff_kv_map_utils::bff_key_t key) const
+  {
+    const uint64_t hash = hash_key(key);
+
+    if (const auto value = stash.find(hash); value.has_value()) [[unlikely]] {
+      return *value;
+    }
+
+    return recover_from_hash(hash);
+  }
+
+  /**
+   * @brief Recover values associated with many keys, as `bff_for_kv_map_t::recover_batch` does, looking up stashed keys in the stash.
+   *
+   * @param keys The keys to query.
+   * @param values The array to write recovered values to, must be as long as keys.
+   * @return True if values were recovered, false if lengths of keys and values differ.
+   */
+  bool recover_batch(std::span<const bff_kv_map_utils::bff_key_t> keys, std::span<uint32_t> values) const
+  {
+    return recover_batch_with_lookup(keys, values, [this](const uint64_t hash) { return stash.find(hash); });
+  }
+
+  /**
+   * @brief Get the hash evaluations for a given key, i.e. its three fingerprint slots, unless it is stashed.
+   *
+   * @param key The key to evaluate.
+   * @return An array of three hash evaluations, or none if the key is stashed, as its value isn't encoded in fingerprints.
+   */
+  std::optional<std::array<uint32_t, 3>> get_hash_evals(const bff_kv_map_utils::bff_key_t key) const
+  {
+    if (stash.find(hash_key(key)).has_value()) [[unlikely]] {
+      return std::nullopt;
+    }
+
+    return bff_for_kv_map_t::get_hash_evals(key);
+  }
+};
+
+}
@@ -0,0 +1,67 @@
+#pragma once
+#include <vector>
+
+#ifdef BFF_FOR_KV_MAP_NUMA
+#include <numa.h>
+#endif
+
+// NUMA placement helpers, which are no-ops, unless compiled with `BFF_FOR_KV_MAP_NUMA` defined and linked against libnuma.
+// Linux places a page on the NUMA node of the thread which first touches it, so binding a thread to a node, before it allocates and zero-fills
+// its working set, keeps that working set local to the thread.
+// Only speculative construction binds threads. Each attempt's scratch space is kept whole on the node of the single thread peeling it, as splitting
+// it across nodes would turn most of that thread's random accesses remote. Serial construction isn't bound, so first touch places its scratch space
+// on whichever node the calling thread runs on.
+namespace bff_kv_map_utils {
+
+// Returns NUMA nodes, which the calling thread is allowed to run on. It's a single node i.e. 0, if NUMA support isn't compiled in or not available.
+static inline std::vector<int>
+numa_nodes_of_current_thread()
+{
+  std::vector<int> nodes;
+
+#ifdef BFF_FOR_KV_MAP_NUMA
+  if (numa_available() >= 0) {
+    bitmask* const run_node_mask = numa_get_run_node_mask();
+
+    for (int node = 0; node <= numa_max_node(); node++) {
+      if (numa_bitmask_isbitset(run_node_mask, node)) {
+        nodes.push_back(node);
+      }
+    }
+
+    numa_bitmask_free(run_node_mask);
+  }
+#endif
+
+  if (nodes.empty()) {
+    nodes.push_back(0);
+  }
+
+  return nodes;
+}
+
+// Binds the calling thread to CPUs of given NUMA node, and makes it prefer allocating memory from that node.
+static inline void
+bind_current_thread_to_numa_node([[maybe_unused]] const int node)
+{
+#ifdef BFF_FOR_KV_MAP_NUMA
+  if (numa_available() >= 0) {
+    numa_run_on_node(node);
+    numa_set_preferred(node);
+  }
+#endif
+}
+
+// Lets the calling thread run on any NUMA node again, allocating memory from whichever node it runs on.
+static inline void
+unbind_current_thread_from_numa_node()
+{
+#ifdef BFF_FOR_KV_MAP_NUMA
+  if (numa_available() >= 0) {
+    numa_run_on_node(-1);
+    numa_set_localalloc();
+  }
+#endif
+}
+
+}
@@ -0,0 +1,273 @@
+#pragma once
+#include "filter_for_kv_map.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Number of keys, cuckoo assignment of a batch of keys evicts, before giving up.
+constexpr size_t BFF_FOR_KV_MAP_PIR_MAX_EVICTION_COUNT = 512;
+// Marks a bucket, which answers no key of the batch. It's queried all the same, so that the server can't tell which buckets are real.
+constexpr uint32_t BFF_FOR_KV_MAP_PIR_NO_KEY = std::numeric_limits<uint32_t>::max();
+
+// Batches queries of many keys, for Private Information Retrieval (PIR) over fingerprints of a Binary Fuse Filter for Key-Value Map, as done in
+// https://github.com/claucece/chalamet, s.t. one server pass answers all of them. Fingerprint array is partitioned into buckets of w consecutive
+// whole segments, each extended by w + 1 segments on either side. Three fingerprint slots of a key lie in three consecutive segments, so the bucket
+// owning the segment of its middle hash evaluation, along with both its neighbours, holds all three of them. With one segment per bucket, those are
+// exactly the buckets owning segments of the three hash evaluations. Keys are assigned to buckets cuckoo-style, with those three buckets as choices,
+// at most one key per bucket. Each bucket is then queried with a selection vector, as long as the bucket, with 1s at the slots of its key, and the
+// server answers every bucket with the inner product of its fingerprints and its query. A key's value is its bucket's answer, unmasked with the key
+// fingerprint. Server work per pass is the total length of buckets, i.e. ~(3 + 2 / w) times the fingerprint array, against the whole array per key,
+// when queried one key at a time. Only the plaintext layouts are computed here, encrypting queries and decrypting answers is left to the PIR scheme,
+// as they're linear in both.
+struct bff_for_kv_map_pir_batch_t
+{
+private:
+  uint32_t segment_length = 0;
+  uint32_t segments_per_bucket = 0;
+  uint32_t array_length = 0;
+  uint64_t plaintext_modulo = 0;
+
+  // Fingerprint slot range [begin, end) of each bucket, and offset of its query, in the query of the whole batch.
+  std::vector<std::pair<uint32_t, uint32_t>> bucket_slots;
+  std::vector<size_t> query_offsets;
+
+public:
+  /**
+   * @brief Construct layout of buckets, for batched PIR queries over fingerprints of a Binary Fuse Filter for Key-Value Map. It only depends on
+   * public parameters of the filter, so that client and server agree on it.
+   *
+   * @param filter The filter, whose fingerprints are queried.
+   * @param num_buckets Number of buckets, fingerprint array is partitioned into, must be non-zero. Buckets consist of whole segments, so there are
+   * no more buckets than segments. A batch of keys must have no more keys than buckets, and cuckoo assignment rarely fails, when there are at least
+   * three times as many buckets as keys. More buckets mean fewer segments per bucket, hence relatively more overlap, the server processes.
+   */
+  explicit bff_for_kv_map_pir_batch_t(const bff_for_kv_map_t& filter, const size_t num_buckets)
+  {
+    if ((num_buckets == 0) || (filter.segment_length == 0)) [[unlikely]] {
+      throw std::runtime_error("PIR batch needs a non-empty Binary Fuse Filter and at least one bucket.");
+    }
+
+    segment_length = filter.segment_length;
+    array_length = filter.array_length;
+    plaintext_modulo = filter.plaintext_modulo;
+
+    const uint32_t num_segments = array_length / segment_length;
+    segments_per_bucket = std::max<uint32_t>(static_cast<uint32_t>(num_segments / std::min<size_t>(num_buckets, num_segments)), 1);
+
+    const uint32_t overlap = segments_per_bucket + 1;
+
+    query_offsets.push_back(0);
+    for (uint32_t segment_begin = 0; segment_begin < num_segments; segment_begin += segments_per_bucket) {
+      const uint32_t segment_end = std::min(segment_begin + segments_per_bucket, num_segments);
+
+      const uint32_t slot_begin = (std::max(segment_begin, overlap) - overlap) * segment_length;
+      const uint32_t slot_end = std::min(segment_end + overlap, num_segments) * segment_length;
+
+      bucket_slots.emplace_back(slot_begin, slot_end);
+      query_offsets.push_back(query_offsets.back() + (slot_end - slot_begin));
+    }
+  }
+
+  /**
+   * @brief Get the number of buckets, fingerprint array is partitioned into. It's at least as many as requested, unless the filter has fewer
+   * segments, as buckets consist of whole segments.
+   *
+   * @return The number of buckets.
+   */
+  size_t num_buckets() const { return bucket_slots.size(); }
+
+  /**
+   * @brief Get the range of fingerprint slots, a bucket holds.
+   *
+   * @param bucket Index of the bucket.
+   * @return Slot range [begin, end).
+   */
+  std::pair<uint32_t, uint32_t> get_bucket_slots(const size_t bucket) const { return bucket_slots[bucket]; }
+
+  /**
+   * @brief Get the number of elements in the query of a batch, which is the total length of buckets, i.e. the number of fingerprints, the server
+   * processes to answer it.
+   *
+   * @return The number of query elements.
+   */
+  size_t query_num_elements() const { return query_offsets.back(); }
+
+  /**
+   * @brief Get the buckets, a key may be assigned to, given its hash evaluations, i.e. the bucket owning the segment of its middle hash evaluation,
+   * and both its neighbours, each of which holds all three slots of the key. At either end of the fingerprint array, the missing neighbour is
+   * replaced by the bucket owning the middle hash evaluation, so that candidates repeat.
+   *
+   * @param hash_evals Hash evaluations of the key, as returned by `bff_for_kv_map_t::get_hash_evals`.
+   * @return Three candidate buckets.
+   */
+  std::array<uint32_t, 3> get_candidate_buckets(const std::array<uint32_t, 3>& hash_evals) const
+  {
+    const auto bucket = static_cast<uint32_t>((hash_evals[1] / segment_length) / segments_per_bucket);
+    const auto last_bucket = static_cast<uint32_t>(num_buckets() - 1);
+
+    return { (bucket == 0) ? bucket : (bucket - 1), bucket, std::min(bucket + 1, last_bucket) };
+  }
+
+  /**
+   * @brief Client side: assign a batch of keys to buckets, cuckoo-style, with their candidate buckets as choices, s.t. each bucket answers at most
+   * one key. When all candidate buckets of a key are taken, it evicts the key of a random one of them, other than the
+   * one it was itself just evicted from, and the evicted key moves on to its other choices.
+   *
+   * @param hash_evals Hash evaluations of keys of the batch, as returned by `bff_for_kv_map_t::get_hash_evals`.
+   * @param key_of_bucket Index of the key, each bucket answers, or `BFF_FOR_KV_MAP_PIR_NO_KEY`, must be as long as the number of buckets.
+   * @return True if all keys were assigned, false if length of `key_of_bucket` is wrong, there are more keys than buckets, or assignment ran out of
+   * evictions, in which case the batch must be split up, and `key_of_bucket` is left unspecified.
+   */
+  bool assign(std::span<const std::array<uint32_t, 3>> hash_evals, std::span<uint32_t> key_of_bucket) const
+  {
+    if ((key_of_bucket.size() != num_buckets()) || (hash_evals.size() > num_buckets())) [[unlikely]] {
+      return false;
+    }
+
+    std::fill(key_of_bucket.begin(), key_of_bucket.end(), BFF_FOR_KV_MAP_PIR_NO_KEY);
+
+    // Evictions only need to be unpredictable to a pathological batch, not to the server, which never sees them, so a fixed seed keeps
+    // assignment reproducible.
+    std::minstd_rand gen(static_cast<uint32_t>(hash_evals.size()));
+    size_t num_evictions = 0;
+
+    for (size_t key_idx = 0; key_idx < hash_evals.size(); key_idx++) {
+      uint32_t key = static_cast<uint32_t>(key_idx);
+      uint32_t evicted_from = BFF_FOR_KV_MAP_PIR_NO_KEY;
+
+      while (true) {
+        const auto candidates = get_candidate_buckets(hash_evals[key]);
+
+        const auto free_bucket =
+          std::find_if(candidates.begin(), candidates.end(), [&](const uint32_t bucket) { return key_of_bucket[bucket] == BFF_FOR_KV_MAP_PIR_NO_KEY; });
+        if (free_bucket != candidates.end()) {
+          key_of_bucket[*free_bucket] = key;
+          break;
+        }
+
+        if (num_evictions == BFF_FOR_KV_MAP_PIR_MAX_EVICTION_COUNT) [[unlikely]] {
+          return false;
+        }
+        num_evictions++;
+
+        const bool has_other_choice =
+          std::any_of(candidates.begin(), candidates.end(), [&](const uint32_t bucket) { return bucket != evicted_from; });
+
+        uint32_t bucket = candidates[gen() % candidates.size()];
+        while (has_other_choice && (bucket == evicted_from)) {
+          bucket = candidates[gen() % candidates.size()];
+        }
+
+        std::swap(key, key_of_bucket[bucket]);
+        evicted_from = bucket;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Client side: lay out the query of a batch of keys, i.e. the selection vector of each bucket, back to back. Selection vector of a bucket
+   * has 1s at the three slots of its key, relative to the start of the bucket, and 0s elsewhere, or is all 0s, when it answers no key.
+   *
+   * @param hash_evals Hash evaluations of keys of the batch.
+   * @param key_of_bucket Assignment of keys to buckets, as computed by `assign`.
+   * @param batch_query The array to write the query to, must be `query_num_elements` long.
+   * @return True if the query was laid out, false if lengths of `key_of_bucket` or `query` are wrong.
+   */
+  bool query(std::span<const std::array<uint32_t, 3>> hash_evals, std::span<const uint32_t> key_of_bucket, std::span<uint32_t> batch_query) const
+  {
+    if ((key_of_bucket.size() != num_buckets()) || (batch_query.size() != query_num_elements())) [[unlikely]] {
+      return false;
+    }
+
+    std::fill(batch_query.begin(), batch_query.end(), 0);
+
+    for (size_t bucket = 0; bucket < num_buckets(); bucket++) {
+      const uint32_t key = key_of_bucket[bucket];
+      if (key == BFF_FOR_KV_MAP_PIR_NO_KEY) {
+        continue;
+      }
+
+      for (const auto slot : hash_evals[key]) {
+        batch_query[query_offsets[bucket] + (slot - bucket_slots[bucket].first)] = 1;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Server side: answer the query of a batch of keys, in one pass over buckets, with the inner product of fingerprints of each bucket and its
+   * selection vector, modulo 2^32. It never learns which buckets answer a key, once the query is encrypted.
+   *
+   * @param fingerprints_mod_p Fingerprints of the filter, as returned by `bff_for_kv_map_t::get_fingerprints_mod_p`.
+   * @param batch_query Query of the batch, as laid out by `query`.
+   * @param answers The array to write the answer of each bucket to, must be as long as the number of buckets.
+   * @return True if the query was answered, false if lengths of `fingerprints_mod_p`, `query` or `answers` are wrong.
+   */
+  bool answer(std::span<const uint32_t> fingerprints_mod_p, std::span<const uint32_t> batch_query, std::span<uint32_t> answers) const
+  {
+    if ((fingerprints_mod_p.size() != array_length) || (batch_query.size() != query_num_elements()) || (answers.size() != num_buckets())) [[unlikely]] {
+      return false;
+    }
+
+    for (size_t bucket = 0; bucket < num_buckets(); bucket++) {
+      const auto [slot_begin, slot_end] = bucket_slots[bucket];
+
+      const auto bucket_fingerprints = fingerprints_mod_p.subspan(slot_begin, slot_end - slot_begin);
+      const auto bucket_query = batch_query.subspan(query_offsets[bucket], bucket_fingerprints.size());
+
+      uint32_t inner_product = 0;
+      for (size_t i = 0; i < bucket_fingerprints.size(); i++) {
+        inner_product += bucket_fingerprints[i] * bucket_query[i];
+      }
+
+      answers[bucket] = inner_product;
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Client side: recover values of a batch of keys, from answers of their buckets.
+   *
+   * @param key_fingerprints Fingerprints of keys of the batch, as returned by `bff_for_kv_map_t::get_key_fingerprint`.
+   * @param key_of_bucket Assignment of keys to buckets, as computed by `assign`.
+   * @param answers Answer of each bucket, as computed by `answer`.
+   * @param values The array to write recovered values to, must be as long as `key_fingerprints`.
+   * @return True if values were recovered, false if lengths of `key_of_bucket`, `answers` or `values` are wrong.
+   */
+  bool decode(std::span<const uint64_t> key_fingerprints,
+              std::span<const uint32_t> key_of_bucket,
+              std::span<const uint32_t> answers,
+              std::span<uint32_t> values) const
+  {
+    if ((key_of_bucket.size() != num_buckets()) || (answers.size() != num_buckets()) || (values.size() != key_fingerprints.size())) [[unlikely]] {
+      return false;
+    }
+
+    for (size_t bucket = 0; bucket < num_buckets(); bucket++) {
+      const uint32_t key = key_of_bucket[bucket];
+      if (key == BFF_FOR_KV_MAP_PIR_NO_KEY) {
+        continue;
+      }
+
+      const uint32_t mask = key_fingerprints[key] % plaintext_modulo;
+      values[key] = (answers[bucket] + mask) % plaintext_modulo;
+    }
+
+    return true;
+  }
+};
+
+}
@@ -0,0 +1,170 @@
+#pragma once
+#include "filter_for_kv_map.hpp"
+#include "utils.hpp"
+#include <array>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <utility>
+
+namespace bff_kv_map {
+
+// Filters which can recover values for many keys at once, such as `bff_for_kv_map_t` and `bff_for_kv_map_local_t`, which also looks up its stash.
+template<typename F>
+concept batch_recoverable_filter = requires(const F& filter, std::span<const bff_kv_map_utils::bff_key_t> keys, std::span<uint32_t> values) {
+  { filter.recover_batch(keys, values) } -> std::same_as<bool>;
+};
+
+// Lazy input view over values recovered from a Binary Fuse Filter for Key-Value Map, for keys pulled from an underlying input range.
+// Keys are pulled in chunks of `tuning_t::recover_batch_size` and recovered using `recover_batch`, so that a pipeline consuming values one by one,
+// still gets cache misses of different keys overlapped. Like `std::ranges::istream_view`, chunk state lives in the view, so it can be iterated only once,
+// and must not be moved while being iterated. The filter must outlive the view. Values are recovered using `recover_batch` of the filter's own type,
+// so that filters with a stash recover stashed keys too.
+template<std::ranges::input_range V, batch_recoverable_filter F>
+  requires std::ranges::view<V> && std::convertible_to<std::ranges::range_reference_t<V>, bff_kv_map_utils::bff_key_t>
+struct recover_view : public std::ranges::view_interface<recover_view<V, F>>
+{
+private:
+  V base_range{};
+  const F* filter = nullptr;
+
+  std::array<bff_kv_map_utils::bff_key_t, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE> chunk_keys{};
+  std::array<uint32_t, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE> chunk_values{};
+  size_t chunk_size = 0;
+  size_t chunk_offset = 0;
+
+  // Pulls next chunk of keys, starting at given position of underlying range, and recovers their values. Returns position after the chunk.
+  std::ranges::iterator_t<V> pull_chunk(std::ranges::iterator_t<V> current)
+  {
+    const auto last = std::ranges::end(base_range);
+    const size_t max_chunk_size = active_tuning().recover_batch_size.load(std::memory_order_relaxed);
+
+    chunk_size = 0;
+    while ((chunk_size < max_chunk_size) && (current != last)) {
+      chunk_keys[chunk_size] = *current;
+      chunk_size++;
+      ++current;
+    }
+
+    filter->recover_batch(std::span(chunk_keys).first(chunk_size), std::span(chunk_values).first(chunk_size));
+    chunk_offset = 0;
+
+    return current;
+  }
+
+public:
+  struct iterator
+  {
+  private:
+    recover_view* parent = nullptr;
+    std::ranges::iterator_t<V> current{};
+
+  public:
+    using iterator_concept = std::input_iterator_tag;
+    using value_type = uint32_t;
+    using difference_type = std::ptrdiff_t;
+
+    iterator() = default;
+    iterator(recover_view* parent, std::ranges::iterator_t<V> current)
+      : parent(parent)
+      , current(std::move(current))
+    {
+    }
+
+    iterator(const iterator&) = delete;
+    iterator& operator=(const iterator&) = delete;
+    iterator(iterator&&) = default;
+    iterator& operator=(iterator&&) = default;
+
+    uint32_t operator*() const { return parent->chunk_values[parent->chunk_offset]; }
+
+    iterator& operator++()
+    {
+      parent->chunk_offset++;
+      if (parent->chunk_offset == parent->chunk_size) {
+        current = parent->pull_chunk(std::move(current));
+      }
+
+      return *this;
+    }
+
+    void operator++(int) { ++*this; }
+
+    bool operator==(std::default_sentinel_t) const { return parent->chunk_offset == parent->chunk_size; }
+  };
+
+  recover_view() = default;
+
+  /**
+   * @brief Construct a view over values recovered from a filter, for keys of an underlying range.
+   *
+   * @param base_range The underlying view of keys.
+   * @param filter The filter to recover values from.
+   */
+  recover_view(V base_range, const F& filter)
+    : base_range(std::move(base_range))
+    , filter(&filter)
+  {
+  }
+
+  iterator begin() { return iterator(this, pull_chunk(std::ranges::begin(base_range))); }
+  std::default_sentinel_t end() const { return std::default_sentinel; }
+
+  auto size()
+    requires std::ranges::sized_range<V>
+  {
+    return std::ranges::size(base_range);
+  }
+};
+
+template<typename R, typename F>
+recover_view(R&&, const F&) -> recover_view<std::views::all_t<R>, F>;
+
+namespace views {
+
+// Range adaptor closure of `recover_view`, so that `keys | bff_kv_map::views::recover(filter)` works in a pipeline.
+template<batch_recoverable_filter F>
+struct recover_adaptor_t
+{
+  const F* filter = nullptr;
+
+  template<std::ranges::viewable_range R>
+  friend auto operator|(R&& keys, const recover_adaptor_t& adaptor)
+  {
+    return recover_view(std::forward<R>(keys), *adaptor.filter);
+  }
+};
+
+/**
+ * @brief Get a range adaptor, which lazily recovers values from given filter, for keys of the range it's applied to.
+ *
+ * @param filter The filter to recover values from, must outlive the resulting view.
+ * @return The range adaptor.
+ */
+template<batch_recoverable_filter F>
+recover_adaptor_t<F>
+recover(const F& filter)
+{
+  return recover_adaptor_t<F>{ &filter };
+}
+
+/**
+ * @brief Get a view, which lazily recovers values from given filter, for keys of given range.
+ *
+ * @param keys The range of keys.
+ * @param filter The filter to recover values from, must outlive the resulting view.
+ * @return The view over recovered values.
+ */
+template<std::ranges::viewable_range R, batch_recoverable_filter F>
+auto
+recover(R&& keys, const F& filter)
+{
+  return recover_view(std::forward<R>(keys), filter);
+}
+
+}
+
+}
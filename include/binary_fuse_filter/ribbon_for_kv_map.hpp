@@ -0,0 +1,386 @@
+#pragma once
+#include "stash.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Number of consecutive fingerprint slots, a key's coefficient row spans over.
+constexpr uint32_t RIBBON_FOR_KV_MAP_BAND_WIDTH = 64;
+// Ratio of number of fingerprint slots ( excluding the band width tail ) to number of keys.
+constexpr double RIBBON_FOR_KV_MAP_SIZE_FACTOR = 1.03;
+// Keys whose rows turn out linearly dependent on earlier ones, are bumped to a stash. At most max(this, num_keys / 256) keys can be bumped.
+constexpr size_t RIBBON_FOR_KV_MAP_MIN_MAX_BUMPED_KEY_COUNT = 64;
+
+// Banded linear-system ( Ribbon ) retrieval for Key Value Maps, an alternative to Binary Fuse Filter for Key Value Maps, with lower space overhead.
+// Each key maps to a random 64 -bit coefficient row over a band of consecutive fingerprint slots, and its value is recovered as sum of
+// fingerprints selected by that row, modulo plaintext modulo. The banded system is solved using on-the-fly Gaussian elimination over GF(2),
+// and lifted to Z_p, one bit at a time, so plaintext modulo must be a power of 2. The few ( ~0.1% ) keys whose rows are linearly dependent
+// on the rows of other keys, are bumped to a small stash.
+// Collects inspiration from "Ribbon filter: practically smaller than Bloom and Xor" @ https://arxiv.org/abs/2103.02515.
+struct ribbon_for_kv_map_t
+{
+private:
+  std::array<uint8_t, 32> seed{};
+
+  uint32_t num_keys_in_kv_map = 0;
+  uint64_t plaintext_modulo = 0;
+  uint64_t label = 0;
+
+  uint32_t num_starts = 0;
+  uint32_t array_length = 0;
+  std::vector<uint32_t> fingerprints;
+  kv_stash_t stash;
+
+public:
+  ribbon_for_kv_map_t() = default;
+
+  ribbon_for_kv_map_t(const ribbon_for_kv_map_t&) = delete;
+  ribbon_for_kv_map_t& operator=(const ribbon_for_kv_map_t&) = delete;
+
+  /**
+   * @brief Move construct a Ribbon Retrieval for Key-Value Map, taking over fingerprints and stash of the source, without copying them. The source is
+   * left as a default constructed retrieval.
+   *
+   * @param other The retrieval to move from.
+   */
+  ribbon_for_kv_map_t(ribbon_for_kv_map_t&& other) noexcept { swap(other); }
+
+  /**
+   * @brief Move assign a Ribbon Retrieval for Key-Value Map, taking over fingerprints and stash of the source, without copying them. Fingerprints and
+   * stash held before assignment are wiped, and the source is left as a default constructed retrieval.
+   *
+   * @param other The retrieval to move from.
+   * @return This retrieval.
+   */
+  ribbon_for_kv_map_t& operator=(ribbon_for_kv_map_t&& other) noexcept
+  {
+    ribbon_for_kv_map_t(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  /**
+   * @brief Construct a Ribbon Retrieval for Key-Value Map.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param values The values of the Key-Value Map s.t. value ∈ [0,plaintext_modulo)
+   * @param plaintext_modulo The plaintext modulo to use, must be a power of 2.
+   * @param label The label to use.
+   */
+  explicit ribbon_for_kv_map_t(std::span<const uint8_t, 32> seed_bytes,
+                               std::span<const bff_kv_map_utils::bff_key_t> keys,
+                               std::span<const uint32_t> values,
+                               const uint64_t plaintext_modulo,
+                               const uint64_t label)
+  {
+    if (keys.size() != values.size()) [[unlikely]] {
+      throw std::runtime_error("Number of keys and values must be equal.");
+    }
+    if (!bff_kv_map_utils::are_all_keys_distinct(keys)) [[unlikely]] {
+      throw std::runtime_error("All keys must be unique.");
+    }
+    if (plaintext_modulo < 256) [[unlikely]] {
+      throw std::runtime_error("Plaintext modulo must be >= 256.");
+    }
+    if (!std::has_single_bit(plaintext_modulo) || (plaintext_modulo > (1UL << 32))) [[unlikely]] {
+      throw std::runtime_error("Plaintext modulo must be a power of 2, <= 2^32.");
+    }
+
+    num_keys_in_kv_map = keys.size();
+    std::copy(seed_bytes.begin(), seed_bytes.end(), this->seed.begin());
+
+    this->plaintext_modulo = plaintext_modulo;
+    this->label = label;
+
+    num_starts = std::max<uint32_t>(1, static_cast<uint32_t>(std::ceil(static_cast<double>(num_keys_in_kv_map) * RIBBON_FOR_KV_MAP_SIZE_FACTOR)));
+    array_length = num_starts + RIBBON_FOR_KV_MAP_BAND_WIDTH - 1;
+
+    // Rows are inserted in order of their start position, which keeps the elimination cache friendly.
+    std::vector<std::tuple<uint32_t, uint64_t, uint64_t, uint32_t>> rows(num_keys_in_kv_map);
+    for (uint32_t i = 0; i < num_keys_in_kv_map; i++) {
+      const uint64_t hash = bff_kv_map_utils::mix256(keys[i].words, seed_bytes);
+      const auto [start, coeff] = hash_to_row(hash);
+      const uint64_t mask = bff_kv_map_utils::mix(hash, label);
+
+      rows[i] = { start, coeff, static_cast<uint64_t>(values[i]) - mask, i };
+    }
+    std::sort(rows.begin(), rows.end());
+
+    std::vector<uint64_t> coeff_rows(array_length, 0);
+    std::vector<uint8_t> rhs_bits(array_length, 0);
+    std::vector<uint64_t> solution_bits(array_length / 64 + 2, 0);
+
+    fingerprints = std::vector<uint32_t>(array_length, 0);
+
+    const size_t max_bumped_key_count = std::max<size_t>(RIBBON_FOR_KV_MAP_MIN_MAX_BUMPED_KEY_COUNT, num_keys_in_kv_map / 256);
+    std::vector<std::pair<uint64_t, uint32_t>> bumped_keys;
+
+    const size_t num_value_bits = static_cast<size_t>(std::countr_zero(plaintext_modulo));
+    for (size_t bit_idx = 0; bit_idx < num_value_bits; bit_idx++) {
+      std::fill(coeff_rows.begin(), coeff_rows.end(), 0);
+      std::fill(rhs_bits.begin(), rhs_bits.end(), 0);
+
+      // Insert a row per key, eliminating over GF(2) using the rows already stored in the band, till it lands on a free pivot slot.
+      // Which rows are linearly dependent doesn't depend on the value bit being solved for, so those are found and bumped in the first pass.
+      for (auto& [start, coeff, residue, key_idx] : rows) {
+        uint32_t pivot = start;
+        uint64_t c = coeff;
+        uint8_t b = static_cast<uint8_t>(residue & 1U);
+
+        while (coeff_rows[pivot] != 0) {
+          c ^= coeff_rows[pivot];
+          b ^= rhs_bits[pivot];
+
+          if (c == 0) [[unlikely]] {
+            break;
+          }
+
+          const int shift = std::countr_zero(c);
+          c >>= shift;
+          pivot += static_cast<uint32_t>(shift);
+        }
+
+        if (c == 0) [[unlikely]] {
+          bumped_keys.emplace_back(bff_kv_map_utils::mix256(keys[key_idx].words, seed_bytes), values[key_idx]);
+          coeff = 0;
+
+          continue;
+        }
+
+        coeff_rows[pivot] = c;
+        rhs_bits[pivot] = b;
+      }
+
+      if (bit_idx == 0) {
+        if (bumped_keys.size() > max_bumped_key_count) [[unlikely]] {
+          bff_kv_map_utils::secure_wipe(std::span(bumped_keys));
+          throw std::runtime_error("Failed to construct Ribbon Retrieval for input Key-Value Map.");
+        }
+
+        std::erase_if(rows, [](const auto& row) { return std::get<1>(row) == 0; });
+        stash = kv_stash_t(std::move(bumped_keys));
+      }
+
+      // Back substitute, from the last slot to the first one, keeping a 64 -bit window of already solved bits.
+      std::fill(solution_bits.begin(), solution_bits.end(), 0);
+
+      uint64_t window = 0;
+      for (uint32_t i = array_length - 1; i < array_length; i--) {
+        window <<= 1U;
+
+        const uint64_t bit = (coeff_rows[i] == 0) ? 0 : ((rhs_bits[i] ^ std::popcount(coeff_rows[i] & window)) & 1U);
+        window |= bit;
+
+        solution_bits[i / 64] |= bit << (i % 64);
+        fingerprints[i] |= static_cast<uint32_t>(bit << bit_idx);
+      }
+
+      // Lift: what remains to be solved for each key, in higher bits, is (residue - row · solution) / 2.
+      for (auto& [start, coeff, residue, _] : rows) {
+        residue = (residue - static_cast<uint64_t>(std::popcount(coeff & solution_window(solution_bits, start)))) >> 1U;
+      }
+    }
+  }
+
+  /**
+   * @brief Construct a Ribbon Retrieval for Key-Value Map from serialized bytes.
+   *
+   * @param bytes The serialized bytes representation of a Ribbon Retrieval.
+   */
+  explicit ribbon_for_kv_map_t(std::span<const uint8_t> bytes)
+  {
+    size_t buffer_offset = 0;
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), seed.size(), seed.begin());
+    buffer_offset += seed.size();
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(num_keys_in_kv_map), reinterpret_cast<uint8_t*>(&num_keys_in_kv_map));
+    buffer_offset += sizeof(num_keys_in_kv_map);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(plaintext_modulo), reinterpret_cast<uint8_t*>(&plaintext_modulo));
+    buffer_offset += sizeof(plaintext_modulo);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(label), reinterpret_cast<uint8_t*>(&label));
+    buffer_offset += sizeof(label);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(num_starts), reinterpret_cast<uint8_t*>(&num_starts));
+    buffer_offset += sizeof(num_starts);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(array_length), reinterpret_cast<uint8_t*>(&array_length));
+    buffer_offset += sizeof(array_length);
+
+    fingerprints = std::vector<uint32_t>(array_length, 0);
+    std::copy_n(bytes.subspan(buffer_offset).begin(), array_length * sizeof(uint32_t), reinterpret_cast<uint8_t*>(fingerprints.data()));
+    buffer_offset += array_length * sizeof(uint32_t);
+
+    stash = kv_stash_t(bytes.subspan(buffer_offset));
+  }
+
+  /**
+   * @brief Destroy the Ribbon Retrieval for Key-Value Map, while zeroing out seed and fingerprints, before their memory is freed. The stash wipes
+   * bumped keys itself.
+   */
+  ~ribbon_for_kv_map_t()
+  {
+    bff_kv_map_utils::secure_wipe(std::span(seed));
+    bff_kv_map_utils::secure_wipe(std::span(fingerprints));
+  }
+
+  /**
+   * @brief Swap two Ribbon Retrievals for Key-Value Map, along with their stashes, without copying their fingerprints.
+   *
+   * @param other The retrieval to swap with.
+   */
+  void swap(ribbon_for_kv_map_t& other) noexcept
+  {
+    std::swap(seed, other.seed);
+
+    std::swap(num_keys_in_kv_map, other.num_keys_in_kv_map);
+    std::swap(plaintext_modulo, other.plaintext_modulo);
+    std::swap(label, other.label);
+
+    std::swap(num_starts, other.num_starts);
+    std::swap(array_length, other.array_length);
+    fingerprints.swap(other.fingerprints);
+    stash.swap(other.stash);
+  }
+
+  friend void swap(ribbon_for_kv_map_t& lhs, ribbon_for_kv_map_t& rhs) noexcept { lhs.swap(rhs); }
+
+  /**
+   * @brief Get the number of bits per entry in the Ribbon Retrieval, counting both fingerprints and the stash of bumped keys.
+   *
+   * @return The number of bits per entry.
+   */
+  size_t bits_per_entry() const
+  {
+    const size_t num_fingerprint_bits = fingerprints.size() * static_cast<size_t>(std::log2(plaintext_modulo));
+    const size_t num_stash_bits = stash.serialized_num_bytes() * 8;
+
+    return (num_fingerprint_bits + num_stash_bits) / static_cast<size_t>(num_keys_in_kv_map);
+  }
+
+  /**
+   * @brief Get the size of the serialized representation of the stash of bumped keys in bytes, which is part of `serialized_num_bytes`.
+   *
+   * @return The size in bytes.
+   */
+  size_t stash_num_bytes() const { return stash.serialized_num_bytes(); }
+
+  /**
+   * @brief Get the number of keys kept in the stash, because they were bumped while solving.
+   *
+   * @return The number of stashed keys.
+   */
+  size_t stash_size() const { return stash.size(); }
+
+  /**
+   * @brief Get the size of the serialized representation of the Ribbon Retrieval in bytes.
+   *
+   * @return The size in bytes.
+   */
+  size_t serialized_num_bytes() const
+  {
+    return sizeof(seed) + sizeof(num_keys_in_kv_map) + sizeof(plaintext_modulo) + sizeof(label) + sizeof(num_starts) + sizeof(array_length) +
+           (fingerprints.size() * sizeof(uint32_t)) + stash.serialized_num_bytes();
+  }
+
+  /**
+   * @brief Serialize the Ribbon Retrieval to a byte array.
+   *
+   * @param bytes The byte array to serialize to.
+   * @return True if serialization was successful, false otherwise.
+   */
+  bool serialize(std::span<uint8_t> bytes) const
+  {
+    if (bytes.size() != serialized_num_bytes()) [[unlikely]] {
+      return false;
+    }
+
+    size_t buffer_offset = 0;
+    std::copy_n(seed.begin(), seed.size(), bytes.begin());
+
+    buffer_offset += seed.size();
+    std::copy_n(reinterpret_cast<const uint8_t*>(&num_keys_in_kv_map), sizeof(num_keys_in_kv_map), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(num_keys_in_kv_map);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&plaintext_modulo), sizeof(plaintext_modulo), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(plaintext_modulo);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&label), sizeof(label), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(label);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&num_starts), sizeof(num_starts), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(num_starts);
+    std::copy_n(reinterpret_cast<const uint8_t*>(&array_length), sizeof(array_length), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += sizeof(array_length);
+    std::copy_n(reinterpret_cast<const uint8_t*>(fingerprints.data()), array_length * sizeof(uint32_t), bytes.subspan(buffer_offset).begin());
+
+    buffer_offset += array_length * sizeof(uint32_t);
+    return stash.serialize(bytes.subspan(buffer_offset));
+  }
+
+  /**
+   * @brief Recover the value associated with a given key.
+   *
+   * @param key The key to query.
+   * @return The value associated with the key.
+   */
+  uint32_t recover(const bff_kv_map_utils::bff_key_t key) const
+  {
+    const uint64_t hash = bff_kv_map_utils::mix256(key.words, seed);
+    if (const auto value = stash.find(hash); value.has_value()) [[unlikely]] {
+      return *value;
+    }
+
+    const auto [start, coeff] = hash_to_row(hash);
+
+    // Branchless, so that the fixed size band gets vectorized.
+    const uint32_t* const band = fingerprints.data() + start;
+
+    uint32_t data = 0;
+    for (size_t i = 0; i < RIBBON_FOR_KV_MAP_BAND_WIDTH; i++) {
+      data += band[i] & (0U - static_cast<uint32_t>((coeff >> i) & 1U));
+    }
+
+    const uint32_t mask = bff_kv_map_utils::mix(hash, label) % plaintext_modulo;
+    return (data + mask) % plaintext_modulo;
+  }
+
+private:
+  // Maps hash of a key to its band start position and coefficient row. Lowest coefficient bit is always set, so that the row's pivot is at its start.
+  constexpr std::tuple<uint32_t, uint64_t> hash_to_row(const uint64_t hash) const
+  {
+    const auto start = static_cast<uint32_t>(bff_kv_map_utils::mulhi(hash, this->num_starts));
+    const uint64_t coeff = bff_kv_map_utils::murmur64(hash ^ 0x9e3779b97f4a7c15UL) | 1UL;
+
+    return { start, coeff };
+  }
+
+  // Extracts 64 consecutive solution bits, beginning at bit index `start`.
+  static constexpr uint64_t solution_window(std::span<const uint64_t> solution_bits, const uint32_t start)
+  {
+    const size_t word_idx = start / 64;
+    const size_t bit_idx = start % 64;
+
+    const uint64_t lo = solution_bits[word_idx] >> bit_idx;
+    const uint64_t hi = (bit_idx == 0) ? 0 : (solution_bits[word_idx + 1] << (64 - bit_idx));
+
+    return lo | hi;
+  }
+};
+
+}
@@ -0,0 +1,193 @@
+#pragma once
+#include "utils.hpp"
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <utility>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Smallest number of bits in the bitmap, summarizing stashed key hashes.
+constexpr size_t KV_STASH_MIN_BITMAP_BIT_COUNT = 4096;
+// Bitmap bits per stashed key. Keeps false positive rate of the bitmap, for keys which are not stashed, below 1/64.
+constexpr size_t KV_STASH_BITMAP_BITS_PER_KEY = 64;
+
+// Exact map of few keys ( identified by their 64 -bit hash ) to values, which a filter failed to encode in its fingerprints.
+// Stashed hashes are summarized in a bitmap, so that almost all lookups for non-stashed keys return after a single bit test.
+struct kv_stash_t
+{
+private:
+  std::vector<std::pair<uint64_t, uint32_t>> entries;
+  std::vector<uint64_t> bitmap;
+
+public:
+  kv_stash_t() = default;
+
+  kv_stash_t(const kv_stash_t&) = delete;
+  kv_stash_t& operator=(const kv_stash_t&) = delete;
+
+  /**
+   * @brief Move construct a stash, taking over entries of the source, which is left empty.
+   *
+   * @param other The stash to move from.
+   */
+  kv_stash_t(kv_stash_t&& other) noexcept { swap(other); }
+
+  /**
+   * @brief Move assign a stash, taking over entries of the source, which is left empty. Entries held before assignment are wiped.
+   *
+   * @param other The stash to move from.
+   * @return This stash.
+   */
+  kv_stash_t& operator=(kv_stash_t&& other) noexcept
+  {
+    kv_stash_t(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  /**
+   * @brief Destroy the stash, while zeroing out stashed key hashes and values, as well as the bitmap summarizing them, before their memory is freed.
+   */
+  ~kv_stash_t()
+  {
+    bff_kv_map_utils::secure_wipe(std::span(entries));
+    bff_kv_map_utils::secure_wipe(std::span(bitmap));
+  }
+
+  /**
+   * @brief Swap two stashes, without copying their entries.
+   *
+   * @param other The stash to swap with.
+   */
+  void swap(kv_stash_t& other) noexcept
+  {
+    entries.swap(other.entries);
+    bitmap.swap(other.bitmap);
+  }
+
+  /**
+   * @brief Construct a stash from (key hash, value) pairs.
+   *
+   * @param entries The stashed (key hash, value) pairs, need not be sorted.
+   */
+  explicit kv_stash_t(std::vector<std::pair<uint64_t, uint32_t>> entries)
+    : entries(std::move(entries))
+  {
+    std::sort(this->entries.begin(), this->entries.end());
+    fill_bitmap();
+  }
+
+  /**
+   * @brief Construct a stash from serialized bytes, which may be followed by other bytes.
+   *
+   * @param bytes The serialized bytes representation of a stash.
+   */
+  explicit kv_stash_t(std::span<const uint8_t> bytes)
+  {
+    size_t buffer_offset = 0;
+
+    uint32_t num_entries = 0;
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(num_entries), reinterpret_cast<uint8_t*>(&num_entries));
+    buffer_offset += sizeof(num_entries);
+
+    entries = std::vector<std::pair<uint64_t, uint32_t>>(num_entries);
+    for (auto& [hash, value] : entries) {
+      std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(hash), reinterpret_cast<uint8_t*>(&hash));
+      buffer_offset += sizeof(hash);
+
+      std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(value), reinterpret_cast<uint8_t*>(&value));
+      buffer_offset += sizeof(value);
+    }
+
+    fill_bitmap();
+  }
+
+  /**
+   * @brief Get the number of stashed keys.
+   *
+   * @return The number of stashed keys.
+   */
+  size_t size() const { return entries.size(); }
+
+  /**
+   * @brief Get the size of the serialized representation of the stash in bytes. The bitmap is not serialized, it is rebuilt when deserializing.
+   *
+   * @return The size in bytes.
+   */
+  size_t serialized_num_bytes() const { return sizeof(uint32_t) + (entries.size() * (sizeof(uint64_t) + sizeof(uint32_t))); }
+
+  /**
+   * @brief Serialize the stash to a byte array.
+   *
+   * @param bytes The byte array to serialize to.
+   * @return True if serialization was successful, false otherwise.
+   */
+  bool serialize(std::span<uint8_t> bytes) const
+  {
+    if (bytes.size() != serialized_num_bytes()) [[unlikely]] {
+      return false;
+    }
+
+    size_t buffer_offset = 0;
+
+    const uint32_t num_entries = static_cast<uint32_t>(entries.size());
+    std::copy_n(reinterpret_cast<const uint8_t*>(&num_entries), sizeof(num_entries), bytes.subspan(buffer_offset).begin());
+    buffer_offset += sizeof(num_entries);
+
+    for (const auto& [hash, value] : entries) {
+      std::copy_n(reinterpret_cast<const uint8_t*>(&hash), sizeof(hash), bytes.subspan(buffer_offset).begin());
+      buffer_offset += sizeof(hash);
+
+      std::copy_n(reinterpret_cast<const uint8_t*>(&value), sizeof(value), bytes.subspan(buffer_offset).begin());
+      buffer_offset += sizeof(value);
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Find the value associated with a key hash, if it is stashed.
+   *
+   * @param hash The 64 -bit hash of the queried key.
+   * @return The stashed value, if any.
+   */
+  std::optional<uint32_t> find(const uint64_t hash) const
+  {
+    if (entries.empty()) {
+      return std::nullopt;
+    }
+
+    const size_t idx = bitmap_index(hash);
+    if (((bitmap[idx / 64] >> (idx % 64)) & 1UL) == 0) [[likely]] {
+      return std::nullopt;
+    }
+
+    const auto it = std::lower_bound(entries.begin(), entries.end(), hash, [](const auto& entry, const uint64_t h) { return entry.first < h; });
+    if ((it == entries.end()) || (it->first != hash)) {
+      return std::nullopt;
+    }
+
+    return it->second;
+  }
+
+private:
+  // Key hashes are remixed, because keys which a filter fails to encode tend to share bits of their hashes.
+  size_t bitmap_index(const uint64_t hash) const { return static_cast<size_t>(bff_kv_map_utils::murmur64(hash)) & ((bitmap.size() * 64) - 1); }
+
+  void fill_bitmap()
+  {
+    const size_t num_bits = std::bit_ceil(std::max(KV_STASH_MIN_BITMAP_BIT_COUNT, entries.size() * KV_STASH_BITMAP_BITS_PER_KEY));
+    bitmap = std::vector<uint64_t>(num_bits / 64, 0);
+
+    for (const auto& [hash, _] : entries) {
+      const size_t idx = bitmap_index(hash);
+      bitmap[idx / 64] |= 1UL << (idx % 64);
+    }
+  }
+};
+
+}
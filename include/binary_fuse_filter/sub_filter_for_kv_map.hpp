@@ -0,0 +1,189 @@
+#pragma once
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Read-only view of a sub-filter, as extracted by `bff_for_kv_map_t::extract_sub_filter`, which holds only those fingerprint slot ranges, needed
+// for recovering values associated with a known subset of keys. Fingerprints are read in place, from the serialized bytes, which must outlive the view.
+struct bff_for_kv_map_sub_filter_view_t
+{
+private:
+  std::array<uint8_t, 32> seed{};
+
+  uint32_t num_keys_in_kv_map = 0;
+  uint64_t plaintext_modulo = 0;
+  uint64_t label = 0;
+
+  uint32_t segment_length = 0;
+  uint32_t segment_length_mask = 0;
+  uint32_t segment_count = 0;
+  uint32_t segment_count_length = 0;
+  uint32_t array_length = 0;
+
+  // Per slot range: its first slot, in sorted order, offset of its first fingerprint in `fingerprints` and its number of slots.
+  std::vector<uint32_t> range_first_slots;
+  std::vector<uint32_t> range_offsets;
+  std::vector<uint32_t> range_num_slots;
+  std::span<const uint8_t> fingerprints;
+
+public:
+  bff_for_kv_map_sub_filter_view_t() = default;
+
+  /**
+   * @brief Construct a view of a serialized sub-filter.
+   *
+   * @param bytes The serialized sub-filter, see `bff_for_kv_map_t::extract_sub_filter` for the layout.
+   */
+  explicit bff_for_kv_map_sub_filter_view_t(std::span<const uint8_t> bytes)
+  {
+    constexpr size_t header_num_bytes = sizeof(seed) + sizeof(num_keys_in_kv_map) + sizeof(plaintext_modulo) + sizeof(label) + sizeof(segment_length) +
+                                        sizeof(segment_count) + sizeof(segment_count_length) + sizeof(array_length) + sizeof(uint32_t);
+    if (bytes.size() < header_num_bytes) [[unlikely]] {
+      throw std::runtime_error("Serialized sub-filter is too short.");
+    }
+
+    size_t buffer_offset = 0;
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), seed.size(), seed.begin());
+    buffer_offset += seed.size();
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(num_keys_in_kv_map), reinterpret_cast<uint8_t*>(&num_keys_in_kv_map));
+    buffer_offset += sizeof(num_keys_in_kv_map);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(plaintext_modulo), reinterpret_cast<uint8_t*>(&plaintext_modulo));
+    buffer_offset += sizeof(plaintext_modulo);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(label), reinterpret_cast<uint8_t*>(&label));
+    buffer_offset += sizeof(label);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(segment_length), reinterpret_cast<uint8_t*>(&segment_length));
+    buffer_offset += sizeof(segment_length);
+
+    segment_length_mask = segment_length - 1;
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(segment_count), reinterpret_cast<uint8_t*>(&segment_count));
+    buffer_offset += sizeof(segment_count);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(segment_count_length), reinterpret_cast<uint8_t*>(&segment_count_length));
+    buffer_offset += sizeof(segment_count_length);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(array_length), reinterpret_cast<uint8_t*>(&array_length));
+    buffer_offset += sizeof(array_length);
+
+    // Same bounds as on construction of the full filter, so that recovering neither divides by zero, nor probes beyond the filter.
+    const bool is_consistent = bff_kv_map_utils::is_consistent_segment_layout(segment_length, segment_count, segment_count_length, array_length);
+    if ((plaintext_modulo < 256) || !is_consistent) [[unlikely]] {
+      throw std::runtime_error("Serialized sub-filter is malformed.");
+    }
+
+    uint32_t num_ranges = 0;
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(num_ranges), reinterpret_cast<uint8_t*>(&num_ranges));
+    buffer_offset += sizeof(num_ranges);
+
+    if ((bytes.size() - buffer_offset) < (static_cast<size_t>(num_ranges) * 2 * sizeof(uint32_t))) [[unlikely]] {
+      throw std::runtime_error("Serialized sub-filter is too short.");
+    }
+
+    range_first_slots = std::vector<uint32_t>(num_ranges, 0);
+    range_offsets = std::vector<uint32_t>(num_ranges, 0);
+    range_num_slots = std::vector<uint32_t>(num_ranges, 0);
+
+    uint64_t num_fingerprints = 0;
+    uint64_t next_free_slot = 0;
+
+    for (uint32_t range_idx = 0; range_idx < num_ranges; range_idx++) {
+      std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(uint32_t), reinterpret_cast<uint8_t*>(&range_first_slots[range_idx]));
+      buffer_offset += sizeof(uint32_t);
+
+      std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(uint32_t), reinterpret_cast<uint8_t*>(&range_num_slots[range_idx]));
+      buffer_offset += sizeof(uint32_t);
+
+      const uint64_t range_end = static_cast<uint64_t>(range_first_slots[range_idx]) + range_num_slots[range_idx];
+      if ((range_num_slots[range_idx] == 0) || (range_first_slots[range_idx] < next_free_slot) || (range_end > array_length)) [[unlikely]] {
+        throw std::runtime_error("Serialized sub-filter is malformed.");
+      }
+
+      range_offsets[range_idx] = static_cast<uint32_t>(num_fingerprints);
+      num_fingerprints += range_num_slots[range_idx];
+      next_free_slot = range_end;
+    }
+
+    if ((bytes.size() - buffer_offset) != (num_fingerprints * sizeof(uint32_t))) [[unlikely]] {
+      throw std::runtime_error("Serialized sub-filter is malformed.");
+    }
+
+    fingerprints = bytes.subspan(buffer_offset);
+  }
+
+  /**
+   * @brief Get the number of fingerprints held by the sub-filter.
+   *
+   * @return The number of fingerprints.
+   */
+  size_t num_fingerprints() const { return fingerprints.size() / sizeof(uint32_t); }
+
+  /**
+   * @brief Recover the value associated with a given key, if all three fingerprint slots of the key are held by the sub-filter.
+   *
+   * @param key The key to query.
+   * @return The value associated with the key, if the sub-filter holds its slots. As with the full filter, keys outside the key-value map recover
+   * garbage values, when their slots happen to be held.
+   */
+  std::optional<uint32_t> recover(const bff_kv_map_utils::bff_key_t key) const
+  {
+    const uint64_t hash = bff_kv_map_utils::mix256(key.words, seed);
+    const auto [h0, h1, h2] = bff_kv_map_utils::hash_batch(hash, segment_length, segment_length_mask, segment_count_length);
+
+    const auto f0 = fingerprint_at(h0);
+    const auto f1 = fingerprint_at(h1);
+    const auto f2 = fingerprint_at(h2);
+
+    if (!f0.has_value() || !f1.has_value() || !f2.has_value()) {
+      return std::nullopt;
+    }
+
+    const uint32_t data = *f0 + *f1 + *f2;
+    const uint32_t mask = bff_kv_map_utils::mix(hash, label) % plaintext_modulo;
+
+    return (data + mask) % plaintext_modulo;
+  }
+
+private:
+  // Looks up the fingerprint at given slot, among held slot ranges. Binary search is branchless, because its comparisons are unpredictable.
+  std::optional<uint32_t> fingerprint_at(const uint32_t slot) const
+  {
+    if (range_first_slots.empty() || (slot < range_first_slots[0])) {
+      return std::nullopt;
+    }
+
+    size_t range_idx = 0;
+    for (size_t num_candidates = range_first_slots.size(); num_candidates > 1;) {
+      const size_t half = num_candidates / 2;
+
+      range_idx = (range_first_slots[range_idx + half] <= slot) ? (range_idx + half) : range_idx;
+      num_candidates -= half;
+    }
+
+    const uint32_t slot_offset = slot - range_first_slots[range_idx];
+    if (slot_offset >= range_num_slots[range_idx]) {
+      return std::nullopt;
+    }
+
+    uint32_t fingerprint = 0;
+    std::copy_n(fingerprints.subspan((static_cast<size_t>(range_offsets[range_idx]) + slot_offset) * sizeof(uint32_t)).begin(),
+                sizeof(fingerprint),
+                reinterpret_cast<uint8_t*>(&fingerprint));
+
+    return fingerprint;
+  }
+};
+
+}
@@ -0,0 +1,524 @@
+#pragma once
+#include "tuning.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <numeric>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Default number of fingerprints in a tier block i.e. a 4KB page, which is the granularity of tiering, as well as of paging in cold fingerprints.
+constexpr uint32_t BFF_FOR_KV_MAP_TIERED_BLOCK_NUM_FINGERPRINTS = 1024;
+// Every these many probes, on each thread, one is counted towards probe frequency of its tier block.
+constexpr uint32_t BFF_FOR_KV_MAP_TIERED_PROBE_SAMPLING_INTERVAL = 16;
+// Size of huge pages, hot tier is backed by.
+constexpr size_t BFF_FOR_KV_MAP_TIERED_HUGE_PAGE_NUM_BYTES = 2UL << 20;
+// Number of slots, queries in flight are counted in. Each thread counts its queries in one slot, so that threads rarely contend on a counter.
+constexpr size_t BFF_FOR_KV_MAP_TIERED_NUM_READER_SLOTS = 64;
+
+// Tiered, read-only view of a serialized Binary Fuse Filter for Key-Value Map, for filters larger than the memory which can be dedicated to them.
+// Fingerprints are served from a memory-mapped file, i.e. cold tier, except for the most frequently probed blocks of fingerprints, which are copied
+// into a hot tier, backed by pinned huge pages. Probe frequency of blocks is sampled while recovering values, and `rebalance` picks hot blocks based
+// on it. Rebalancing builds a fresh block table and hot tier on the side, and publishes them with an atomic pointer swap, so it never blocks queries.
+// The previous table is freed once queries in flight, which may still be using it, have finished, which is tracked with per-epoch reader counts,
+// much like sleepable RCU. A query pays for two uncontended atomic increments, instead of a lock.
+struct bff_for_kv_map_tiered_t
+{
+private:
+  // Owns a memory mapping.
+  struct mapping_t
+  {
+    void* addr = MAP_FAILED;
+    size_t num_bytes = 0;
+
+    mapping_t() = default;
+    mapping_t(void* addr, const size_t num_bytes)
+      : addr(addr)
+      , num_bytes(num_bytes)
+    {
+    }
+
+    mapping_t(const mapping_t&) = delete;
+    mapping_t& operator=(const mapping_t&) = delete;
+
+    ~mapping_t()
+    {
+      if (addr != MAP_FAILED) {
+        munmap(addr, num_bytes);
+      }
+    }
+  };
+
+  // Maps each tier block to its fingerprints, either in the hot tier, which it owns, or in the memory-mapped file.
+  struct tier_table_t
+  {
+    std::vector<const uint32_t*> block_fingerprints;
+    std::unique_ptr<const mapping_t> hot_tier;
+    size_t num_hot_blocks = 0;
+    bool is_hot_tier_pinned = true;
+  };
+
+  // Counts of queries in flight, which started in an even or odd epoch, for threads sharing the slot.
+  struct alignas(64) reader_slot_t
+  {
+    std::array<std::atomic<uint64_t>, 2> num_readers{};
+  };
+
+  // Keeps the tier table, which was current when a query started, from being freed, until the query finishes.
+  struct table_guard_t
+  {
+  private:
+    std::atomic<uint64_t>* num_readers = nullptr;
+    const tier_table_t* table = nullptr;
+
+  public:
+    explicit table_guard_t(const bff_for_kv_map_tiered_t& filter)
+    {
+      const size_t epoch = filter.epoch.load(std::memory_order_seq_cst);
+
+      num_readers = &filter.reader_slots[reader_slot_index()].num_readers[epoch & 1];
+      num_readers->fetch_add(1, std::memory_order_seq_cst);
+
+      table = filter.tier_table.load(std::memory_order_seq_cst);
+    }
+
+    table_guard_t(const table_guard_t&) = delete;
+    table_guard_t& operator=(const table_guard_t&) = delete;
+
+    ~table_guard_t() { num_readers->fetch_sub(1, std::memory_order_release); }
+
+    const tier_table_t& operator*() const { return *table; }
+    const tier_table_t* operator->() const { return table; }
+  };
+
+  std::array<uint8_t, 32> seed{};
+
+  uint32_t num_keys_in_kv_map = 0;
+  uint64_t plaintext_modulo = 0;
+  uint64_t label = 0;
+
+  uint32_t segment_length = 0;
+  uint32_t segment_length_mask = 0;
+  uint32_t segment_count = 0;
+  uint32_t segment_count_length = 0;
+  uint32_t array_length = 0;
+
+  std::unique_ptr<mapping_t> file_mapping;
+  const uint32_t* cold_fingerprints = nullptr;
+
+  uint32_t block_bit_width = 0;
+  uint32_t num_blocks = 0;
+  std::unique_ptr<std::atomic<uint64_t>[]> block_probe_counts;
+  std::unique_ptr<std::atomic<uint8_t>[]> is_cold_block_hinted;
+
+  std::atomic<const tier_table_t*> tier_table{ nullptr };
+  std::atomic<size_t> epoch{ 0 };
+  std::unique_ptr<reader_slot_t[]> reader_slots = std::make_unique<reader_slot_t[]>(BFF_FOR_KV_MAP_TIERED_NUM_READER_SLOTS);
+  std::mutex rebalance_mutex;
+
+public:
+  /**
+   * @brief Construct a tiered view of a serialized Binary Fuse Filter for Key-Value Map, with all fingerprints initially in cold tier.
+   *
+   * @param file_path Path of the file holding the filter, as serialized by `bff_for_kv_map_t::serialize`. Must not be modified while viewed.
+   * @param block_num_fingerprints Number of fingerprints in a tier block, must be a power of 2, no smaller than `BFF_FOR_KV_MAP_TIERED_BLOCK_NUM_FINGERPRINTS`.
+   */
+  explicit bff_for_kv_map_tiered_t(const std::string& file_path, const uint32_t block_num_fingerprints = BFF_FOR_KV_MAP_TIERED_BLOCK_NUM_FINGERPRINTS)
+  {
+    const bool is_power_of_2 = (block_num_fingerprints & (block_num_fingerprints - 1)) == 0;
+    if ((block_num_fingerprints < BFF_FOR_KV_MAP_TIERED_BLOCK_NUM_FINGERPRINTS) || !is_power_of_2) [[unlikely]] {
+      throw std::runtime_error("Tier block size must be a power of 2, no smaller than a page.");
+    }
+
+    const int fd = open(file_path.c_str(), O_RDONLY);
+    if (fd < 0) [[unlikely]] {
+      throw std::runtime_error("Failed to open filter file.");
+    }
+
+    struct stat file_stat{};
+    const bool is_stat_ok = fstat(fd, &file_stat) == 0;
+    const auto file_num_bytes = is_stat_ok ? static_cast<size_t>(file_stat.st_size) : 0;
+
+    void* const addr = (file_num_bytes == 0) ? MAP_FAILED : mmap(nullptr, file_num_bytes, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED) [[unlikely]] {
+      throw std::runtime_error("Failed to map filter file.");
+    }
+
+    file_mapping = std::make_unique<mapping_t>(addr, file_num_bytes);
+    madvise(addr, file_num_bytes, MADV_RANDOM);
+
+    const size_t fingerprints_offset = parse_header(std::span(static_cast<const uint8_t*>(addr), file_num_bytes));
+    cold_fingerprints = reinterpret_cast<const uint32_t*>(static_cast<const uint8_t*>(addr) + fingerprints_offset);
+
+    block_bit_width = static_cast<uint32_t>(std::countr_zero(block_num_fingerprints));
+    num_blocks = (array_length + block_num_fingerprints - 1) >> block_bit_width;
+    block_probe_counts = std::make_unique<std::atomic<uint64_t>[]>(num_blocks);
+    is_cold_block_hinted = std::make_unique<std::atomic<uint8_t>[]>(num_blocks);
+
+    auto table = std::make_unique<tier_table_t>();
+    table->block_fingerprints.resize(num_blocks);
+
+    for (uint32_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+      table->block_fingerprints[block_idx] = cold_fingerprints + (static_cast<size_t>(block_idx) << block_bit_width);
+    }
+
+    tier_table.store(table.release(), std::memory_order_seq_cst);
+  }
+
+  bff_for_kv_map_tiered_t(const bff_for_kv_map_tiered_t&) = delete;
+  bff_for_kv_map_tiered_t& operator=(const bff_for_kv_map_tiered_t&) = delete;
+
+  ~bff_for_kv_map_tiered_t() { delete tier_table.load(std::memory_order_acquire); }
+
+  /**
+   * @brief Get the number of tier blocks, fingerprints are split into.
+   *
+   * @return The number of tier blocks.
+   */
+  size_t num_blocks_total() const { return num_blocks; }
+
+  /**
+   * @brief Get the number of tier blocks, currently in hot tier.
+   *
+   * @return The number of hot tier blocks.
+   */
+  size_t num_hot_blocks() const { return table_guard_t(*this)->num_hot_blocks; }
+
+  /**
+   * @brief Check whether the hot tier is pinned in RAM. Pinning is best effort, as it's bounded by `RLIMIT_MEMLOCK`, so a hot tier which couldn't be
+   * locked is still used, but its pages may be swapped out under memory pressure. An empty hot tier counts as pinned.
+   *
+   * @return True if the hot tier is locked in RAM.
+   */
+  bool is_hot_tier_pinned() const { return table_guard_t(*this)->is_hot_tier_pinned; }
+
+  /**
+   * @brief Recover the value associated with a given key.
+   *
+   * @param key The key to query.
+   * @return The value associated with the key.
+   */
+  uint32_t recover(const bff_kv_map_utils::bff_key_t key) const
+  {
+    const table_guard_t table(*this);
+
+    const uint64_t hash = bff_kv_map_utils::mix256(key.words, seed);
+    const auto [h0, h1, h2] = bff_kv_map_utils::hash_batch(hash, segment_length, segment_length_mask, segment_count_length);
+
+    sample_probes(h0, h1, h2);
+
+    const uint32_t data = fingerprint_at(*table, h0) + fingerprint_at(*table, h1) + fingerprint_at(*table, h2);
+    const uint32_t mask = bff_kv_map_utils::mix(hash, label) % plaintext_modulo;
+
+    return (data + mask) % plaintext_modulo;
+  }
+
+  /**
+   * @brief Recover values associated with many keys. For each batch of `tuning_t::recover_batch_size` keys, fingerprints are prefetched into cache,
+   * while cold blocks, which haven't been hinted since the last rebalance, are hinted to the kernel with `madvise(MADV_WILLNEED)`, so that page faults
+   * of different keys overlap, before any fingerprint is read. Each cold block is hinted once, as system calls would otherwise cost more than resident
+   * pages save.
+   *
+   * @param keys The keys to query.
+   * @param values The array to write recovered values to, must be as long as keys.
+   * @return True if values were recovered, false if lengths of keys and values differ.
+   */
+  bool recover_batch(std::span<const bff_kv_map_utils::bff_key_t> keys, std::span<uint32_t> values) const
+  {
+    if (keys.size() != values.size()) [[unlikely]] {
+      return false;
+    }
+
+    const size_t batch_size = active_tuning().recover_batch_size.load(std::memory_order_relaxed);
+
+    const table_guard_t table(*this);
+
+    std::array<uint64_t, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE> hashes;
+    std::array<uint32_t, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE * 3> slots;
+    std::array<uint32_t, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE * 3> cold_blocks;
+
+    for (size_t batch_begin = 0; batch_begin < keys.size(); batch_begin += batch_size) {
+      const size_t num_keys_in_batch = std::min(batch_size, keys.size() - batch_begin);
+      size_t num_cold_blocks = 0;
+
+      for (size_t i = 0; i < num_keys_in_batch; i++) {
+        hashes[i] = bff_kv_map_utils::mix256(keys[batch_begin + i].words, seed);
+
+        const auto [h0, h1, h2] = bff_kv_map_utils::hash_batch(hashes[i], segment_length, segment_length_mask, segment_count_length);
+        slots[(i * 3) + 0] = h0;
+        slots[(i * 3) + 1] = h1;
+        slots[(i * 3) + 2] = h2;
+
+        sample_probes(h0, h1, h2);
+
+        for (size_t j = i * 3; j < (i + 1) * 3; j++) {
+          const uint32_t block_idx = slots[j] >> block_bit_width;
+
+          // Prefetching a cold fingerprint, whose page isn't resident, is simply dropped, so both tiers are prefetched.
+          __builtin_prefetch(table->block_fingerprints[block_idx] + (slots[j] & block_mask()));
+
+          // Hot blocks are marked as hinted by `rebalance`, so a single, well predicted, check skips both them and cold blocks hinted already.
+          if (is_cold_block_hinted[block_idx].load(std::memory_order_relaxed) == 0) [[unlikely]] {
+            is_cold_block_hinted[block_idx].store(1, std::memory_order_relaxed);
+            cold_blocks[num_cold_blocks++] = block_idx;
+          }
+        }
+      }
+
+      hint_cold_blocks(std::span(cold_blocks).first(num_cold_blocks));
+
+      for (size_t i = 0; i < num_keys_in_batch; i++) {
+        const uint32_t data =
+          fingerprint_at(*table, slots[(i * 3) + 0]) + fingerprint_at(*table, slots[(i * 3) + 1]) + fingerprint_at(*table, slots[(i * 3) + 2]);
+        const uint32_t mask = bff_kv_map_utils::mix(hashes[i], label) % plaintext_modulo;
+
+        values[batch_begin + i] = (data + mask) % plaintext_modulo;
+      }
+    }
+
+    return true;
+  }
+
+  /**
+   * @brief Move the most frequently probed tier blocks, since the last rebalance, into hot tier, and the rest into cold tier. Safe to call concurrently
+   * with queries, which are never blocked, while concurrent calls to `rebalance` are serialized. It returns once queries, which started before the new
+   * hot tier got published, have finished, and the previous hot tier is freed. Sampled probe counts are halved, so that older probes weigh less, as
+   * access pattern shifts.
+   *
+   * @param max_hot_num_bytes Upper bound on the size of the hot tier, in bytes.
+   * @return True if the new hot tier is pinned in RAM, see `is_hot_tier_pinned`.
+   */
+  bool rebalance(const size_t max_hot_num_bytes)
+  {
+    std::lock_guard<std::mutex> lock(rebalance_mutex);
+
+    const size_t block_num_bytes = (static_cast<size_t>(1) << block_bit_width) * sizeof(uint32_t);
+    const size_t max_num_hot_blocks = std::min<size_t>(num_blocks, max_hot_num_bytes / block_num_bytes);
+
+    std::vector<uint64_t> probe_counts(num_blocks, 0);
+    for (uint32_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+      probe_counts[block_idx] = block_probe_counts[block_idx].load(std::memory_order_relaxed);
+      block_probe_counts[block_idx].fetch_sub(probe_counts[block_idx] / 2, std::memory_order_relaxed);
+    }
+
+    std::vector<uint32_t> blocks(num_blocks);
+    std::iota(blocks.begin(), blocks.end(), 0);
+    std::stable_sort(blocks.begin(), blocks.end(), [&](const uint32_t lhs, const uint32_t rhs) { return probe_counts[lhs] > probe_counts[rhs]; });
+
+    size_t num_hot_blocks = 0;
+    while ((num_hot_blocks < max_num_hot_blocks) && (probe_counts[blocks[num_hot_blocks]] > 0)) {
+      num_hot_blocks++;
+    }
+
+    // Hot blocks are laid out in order of their index, so that neighbouring hot blocks stay neighbours.
+    std::sort(blocks.begin(), blocks.begin() + num_hot_blocks);
+
+    // Only `rebalance` frees tables, so the current one stays alive, while the mutex is held.
+    const tier_table_t* const current_table = tier_table.load(std::memory_order_acquire);
+
+    auto table = std::make_unique<tier_table_t>();
+    table->block_fingerprints.resize(num_blocks);
+    table->num_hot_blocks = num_hot_blocks;
+
+    std::vector<uint8_t> is_hot_block(num_blocks, 0);
+
+    for (uint32_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+      table->block_fingerprints[block_idx] = cold_fingerprints + (static_cast<size_t>(block_idx) << block_bit_width);
+    }
+
+    if (num_hot_blocks > 0) {
+      table->hot_tier = allocate_hot_tier(num_hot_blocks * block_num_bytes);
+      table->is_hot_tier_pinned = mlock(table->hot_tier->addr, table->hot_tier->num_bytes) == 0;
+      auto* const hot_fingerprints = static_cast<uint32_t*>(table->hot_tier->addr);
+
+      for (size_t hot_block_idx = 0; hot_block_idx < num_hot_blocks; hot_block_idx++) {
+        const uint32_t block_idx = blocks[hot_block_idx];
+        const size_t block_begin = static_cast<size_t>(block_idx) << block_bit_width;
+        const size_t block_len = std::min<size_t>(static_cast<size_t>(1) << block_bit_width, array_length - block_begin);
+
+        // Copies from the current table, so that blocks staying hot are copied from hot tier, instead of faulting in pages of the file.
+        uint32_t* const hot_block = hot_fingerprints + (hot_block_idx << block_bit_width);
+        std::copy_n(current_table->block_fingerprints[block_idx], block_len, hot_block);
+
+        table->block_fingerprints[block_idx] = hot_block;
+        is_hot_block[block_idx] = 1;
+      }
+    }
+
+    const bool is_hot_tier_pinned = table->is_hot_tier_pinned;
+    tier_table.store(table.release(), std::memory_order_seq_cst);
+
+    // Pages of cold blocks may have been evicted since they were hinted, so they are hinted afresh, while hot blocks never need a hint. Queries still
+    // using the previous table may skip, or issue, a hint they didn't need to, which is harmless.
+    for (uint32_t block_idx = 0; block_idx < num_blocks; block_idx++) {
+      is_cold_block_hinted[block_idx].store(is_hot_block[block_idx], std::memory_order_relaxed);
+    }
+
+    wait_for_readers();
+    delete current_table;
+
+    return is_hot_tier_pinned;
+  }
+
+private:
+  uint32_t block_mask() const { return (1U << block_bit_width) - 1; }
+
+  // Index of the slot, queries of the calling thread are counted in. Slots are handed out to threads round-robin.
+  static size_t reader_slot_index()
+  {
+    static std::atomic<size_t> next_reader_slot_index{ 0 };
+    thread_local const size_t reader_slot_index = next_reader_slot_index.fetch_add(1, std::memory_order_relaxed) % BFF_FOR_KV_MAP_TIERED_NUM_READER_SLOTS;
+
+    return reader_slot_index;
+  }
+
+  // Waits until queries, which may still be using the tier table replaced last, have finished. A query counts itself in the epoch it read, before
+  // loading the table, so that one, which read the epoch just before it got advanced, may count itself in either epoch. Hence the epoch is advanced
+  // twice, each time waiting for queries of the epoch just left, which never starve, as newly started queries count themselves in the other one.
+  void wait_for_readers()
+  {
+    for (size_t round = 0; round < 2; round++) {
+      const size_t left_epoch = epoch.fetch_add(1, std::memory_order_seq_cst);
+
+      for (size_t slot_idx = 0; slot_idx < BFF_FOR_KV_MAP_TIERED_NUM_READER_SLOTS; slot_idx++) {
+        while (reader_slots[slot_idx].num_readers[left_epoch & 1].load(std::memory_order_seq_cst) != 0) {
+          std::this_thread::yield();
+        }
+      }
+    }
+  }
+
+  uint32_t fingerprint_at(const tier_table_t& table, const uint32_t slot) const
+  {
+    return table.block_fingerprints[slot >> block_bit_width][slot & block_mask()];
+  }
+
+  // Hints given cold blocks to the kernel, with one `madvise` call per run of consecutive blocks, widened to page boundaries.
+  void hint_cold_blocks(std::span<uint32_t> cold_blocks) const
+  {
+    constexpr size_t page_num_bytes = BFF_FOR_KV_MAP_TIERED_BLOCK_NUM_FINGERPRINTS * sizeof(uint32_t);
+
+    auto* const file_bytes = static_cast<uint8_t*>(file_mapping->addr);
+    const auto fingerprints_offset = static_cast<size_t>(reinterpret_cast<const uint8_t*>(cold_fingerprints) - file_bytes);
+    const size_t block_num_bytes = (static_cast<size_t>(1) << block_bit_width) * sizeof(uint32_t);
+
+    std::sort(cold_blocks.begin(), cold_blocks.end());
+
+    for (size_t run_begin = 0; run_begin < cold_blocks.size();) {
+      size_t run_end = run_begin + 1;
+      while ((run_end < cold_blocks.size()) && (cold_blocks[run_end] == cold_blocks[run_end - 1] + 1)) {
+        run_end++;
+      }
+
+      const size_t begin_offset = ((fingerprints_offset + cold_blocks[run_begin] * block_num_bytes) / page_num_bytes) * page_num_bytes;
+      const size_t end_offset = std::min(fingerprints_offset + (cold_blocks[run_end - 1] + 1) * block_num_bytes, file_mapping->num_bytes);
+      madvise(file_bytes + begin_offset, end_offset - begin_offset, MADV_WILLNEED);
+
+      run_begin = run_end;
+    }
+  }
+
+  // Counts one in every `BFF_FOR_KV_MAP_TIERED_PROBE_SAMPLING_INTERVAL` probes, on each thread, towards probe frequency of tier blocks.
+  void sample_probes(const uint32_t h0, const uint32_t h1, const uint32_t h2) const
+  {
+    thread_local uint32_t num_unsampled_probes = 0;
+
+    num_unsampled_probes++;
+    if (num_unsampled_probes == BFF_FOR_KV_MAP_TIERED_PROBE_SAMPLING_INTERVAL) [[unlikely]] {
+      num_unsampled_probes = 0;
+
+      block_probe_counts[h0 >> block_bit_width].fetch_add(1, std::memory_order_relaxed);
+      block_probe_counts[h1 >> block_bit_width].fetch_add(1, std::memory_order_relaxed);
+      block_probe_counts[h2 >> block_bit_width].fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  // Allocates hot tier, backed by huge pages if the system has them reserved, otherwise by transparent huge pages.
+  static std::unique_ptr<const mapping_t> allocate_hot_tier(const size_t num_bytes)
+  {
+    const size_t mapped_num_bytes = ((num_bytes + BFF_FOR_KV_MAP_TIERED_HUGE_PAGE_NUM_BYTES - 1) / BFF_FOR_KV_MAP_TIERED_HUGE_PAGE_NUM_BYTES) *
+                                    BFF_FOR_KV_MAP_TIERED_HUGE_PAGE_NUM_BYTES;
+
+    void* addr = mmap(nullptr, mapped_num_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (addr == MAP_FAILED) {
+      addr = mmap(nullptr, mapped_num_bytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (addr == MAP_FAILED) [[unlikely]] {
+        throw std::bad_alloc();
+      }
+
+      madvise(addr, mapped_num_bytes, MADV_HUGEPAGE);
+    }
+
+    return std::make_unique<const mapping_t>(addr, mapped_num_bytes);
+  }
+
+  // Parses the header of a serialized filter, returning offset of fingerprints.
+  size_t parse_header(std::span<const uint8_t> bytes)
+  {
+    constexpr size_t header_num_bytes = sizeof(seed) + sizeof(num_keys_in_kv_map) + sizeof(plaintext_modulo) + sizeof(label) + sizeof(segment_length) +
+                                        sizeof(segment_count) + sizeof(segment_count_length) + sizeof(array_length);
+    if (bytes.size() < header_num_bytes) [[unlikely]] {
+      throw std::runtime_error("Serialized filter is malformed.");
+    }
+
+    size_t buffer_offset = 0;
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), seed.size(), seed.begin());
+    buffer_offset += seed.size();
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(num_keys_in_kv_map), reinterpret_cast<uint8_t*>(&num_keys_in_kv_map));
+    buffer_offset += sizeof(num_keys_in_kv_map);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(plaintext_modulo), reinterpret_cast<uint8_t*>(&plaintext_modulo));
+    buffer_offset += sizeof(plaintext_modulo);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(label), reinterpret_cast<uint8_t*>(&label));
+    buffer_offset += sizeof(label);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(segment_length), reinterpret_cast<uint8_t*>(&segment_length));
+    buffer_offset += sizeof(segment_length);
+
+    segment_length_mask = segment_length - 1;
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(segment_count), reinterpret_cast<uint8_t*>(&segment_count));
+    buffer_offset += sizeof(segment_count);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(segment_count_length), reinterpret_cast<uint8_t*>(&segment_count_length));
+    buffer_offset += sizeof(segment_count_length);
+
+    std::copy_n(bytes.subspan(buffer_offset).begin(), sizeof(array_length), reinterpret_cast<uint8_t*>(&array_length));
+    buffer_offset += sizeof(array_length);
+
+    // Same bounds as on construction of the filter, so that a corrupt file can neither make recovering divide by zero, nor probe beyond the mapping.
+    const bool is_consistent = bff_kv_map_utils::is_consistent_segment_layout(segment_length, segment_count, segment_count_length, array_length);
+    if ((plaintext_modulo < 256) || !is_consistent) [[unlikely]] {
+      throw std::runtime_error("Serialized filter is malformed.");
+    }
+    if ((bytes.size() - buffer_offset) != (static_cast<size_t>(array_length) * sizeof(uint32_t))) [[unlikely]] {
+      throw std::runtime_error("Serialized filter is malformed.");
+    }
+
+    return buffer_offset;
+  }
+};
+
+}
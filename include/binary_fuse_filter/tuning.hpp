@@ -0,0 +1,185 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+
+// Host specific tuning parameters of batched recovery and construction loops, whose best values depend on memory latency and core type. They're
+// process wide, and initialized on first use from the file named by environment variable `BFF_FOR_KV_MAP_TUNING_FILE`, if set, otherwise defaults are
+// used. Tuning only affects performance, never the filters built or the values recovered. See `autotune.hpp` for picking them on a host.
+namespace bff_kv_map {
+
+// Default number of keys `recover_batch` hashes, and prefetches fingerprint slots of, before summing up fingerprints of any of them. Enough to keep
+// ~96 independent fingerprint loads in flight, while slots of a batch fit in a few cache lines.
+constexpr uint32_t BFF_FOR_KV_MAP_RECOVER_BATCH_SIZE = 32;
+// Upper bound on number of keys `recover_batch` hashes, and prefetches fingerprint slots of, before summing up fingerprints of any of them.
+constexpr uint32_t BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE = 128;
+// Upper bound on how many keys ahead construction prefetches fingerprint slots, while assigning fingerprints.
+constexpr uint32_t BFF_FOR_KV_MAP_MAX_CONSTRUCTION_PREFETCH_DISTANCE = 64;
+
+struct tuning_t
+{
+  // Number of keys `recover_batch` processes per batch, in [1, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE].
+  uint32_t recover_batch_size = BFF_FOR_KV_MAP_RECOVER_BATCH_SIZE;
+  // Number of keys, ahead of the one whose fingerprint is being assigned in reverse peeling order, whose fingerprint slots are prefetched during
+  // construction. 0 disables prefetching.
+  uint32_t construction_prefetch_distance = 0;
+
+  bool operator==(const tuning_t&) const = default;
+};
+
+// Clamps tuning parameters to their valid ranges.
+static inline tuning_t
+clamp_tuning(tuning_t tuning)
+{
+  tuning.recover_batch_size = std::clamp<uint32_t>(tuning.recover_batch_size, 1, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE);
+  tuning.construction_prefetch_distance = std::min(tuning.construction_prefetch_distance, BFF_FOR_KV_MAP_MAX_CONSTRUCTION_PREFETCH_DISTANCE);
+
+  return tuning;
+}
+
+/**
+ * @brief Read tuning parameters from a file of `name=value` lines, as written by `save_tuning`. Parameters missing from the file keep their defaults,
+ * while out of range values are clamped.
+ *
+ * @param file_path Path of the tuning file.
+ * @param tuning Tuning parameters to write parsed ones to, left untouched on failure.
+ * @return True if the file was read, false if it couldn't be opened, or has a malformed line.
+ */
+static inline bool
+read_tuning(const std::string& file_path, tuning_t& tuning)
+{
+  std::ifstream file(file_path);
+  if (!file) {
+    return false;
+  }
+
+  tuning_t parsed_tuning{};
+  std::string line;
+
+  while (std::getline(file, line)) {
+    if (line.empty() || (line.front() == '#')) {
+      continue;
+    }
+
+    const auto separator = line.find('=');
+    if (separator == std::string::npos) {
+      return false;
+    }
+
+    const auto name = line.substr(0, separator);
+    const auto value_str = line.substr(separator + 1);
+
+    char* value_end = nullptr;
+    const auto value = std::strtoul(value_str.c_str(), &value_end, 10);
+    if (value_str.empty() || (*value_end != '\0')) {
+      return false;
+    }
+
+    if (name == "recover_batch_size") {
+      parsed_tuning.recover_batch_size = static_cast<uint32_t>(std::min<unsigned long>(value, BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE));
+    } else if (name == "construction_prefetch_distance") {
+      parsed_tuning.construction_prefetch_distance = static_cast<uint32_t>(std::min<unsigned long>(value, BFF_FOR_KV_MAP_MAX_CONSTRUCTION_PREFETCH_DISTANCE));
+    }
+  }
+
+  tuning = clamp_tuning(parsed_tuning);
+  return true;
+}
+
+/**
+ * @brief Write tuning parameters to a file, as `name=value` lines.
+ *
+ * @param file_path Path of the tuning file, which is overwritten.
+ * @param tuning Tuning parameters to write.
+ * @return True if the file was written, false otherwise.
+ */
+static inline bool
+save_tuning(const std::string& file_path, const tuning_t& tuning)
+{
+  std::ofstream file(file_path, std::ios::trunc);
+  file << "# Tuning parameters of bff-for-kv-map, for this host\n";
+  file << "recover_batch_size=" << tuning.recover_batch_size << '\n';
+  file << "construction_prefetch_distance=" << tuning.construction_prefetch_distance << '\n';
+
+  return static_cast<bool>(file);
+}
+
+// Tuning parameters in effect, each an atomic, so that they can be updated while filters are in use.
+struct active_tuning_t
+{
+  std::atomic<uint32_t> recover_batch_size;
+  std::atomic<uint32_t> construction_prefetch_distance;
+
+  explicit active_tuning_t(const tuning_t tuning)
+    : recover_batch_size(tuning.recover_batch_size)
+    , construction_prefetch_distance(tuning.construction_prefetch_distance)
+  {
+  }
+};
+
+// Has external linkage, unlike other helpers, so that every translation unit shares the same parameters.
+inline active_tuning_t&
+active_tuning()
+{
+  static active_tuning_t active([]() {
+    tuning_t tuning{};
+
+    if (const char* const file_path = std::getenv("BFF_FOR_KV_MAP_TUNING_FILE"); file_path != nullptr) {
+      read_tuning(file_path, tuning);
+    }
+
+    return tuning;
+  }());
+
+  return active;
+}
+
+/**
+ * @brief Get tuning parameters in effect.
+ *
+ * @return The tuning parameters.
+ */
+static inline tuning_t
+get_tuning()
+{
+  const auto& active = active_tuning();
+  return { active.recover_batch_size.load(std::memory_order_relaxed), active.construction_prefetch_distance.load(std::memory_order_relaxed) };
+}
+
+/**
+ * @brief Set tuning parameters in effect, for every filter in the process, clamping them to valid ranges.
+ *
+ * @param tuning The tuning parameters.
+ */
+static inline void
+set_tuning(const tuning_t& tuning)
+{
+  const auto clamped_tuning = clamp_tuning(tuning);
+
+  auto& active = active_tuning();
+  active.recover_batch_size.store(clamped_tuning.recover_batch_size, std::memory_order_relaxed);
+  active.construction_prefetch_distance.store(clamped_tuning.construction_prefetch_distance, std::memory_order_relaxed);
+}
+
+/**
+ * @brief Load tuning parameters from a file, as written by `save_tuning`, and put them in effect.
+ *
+ * @param file_path Path of the tuning file.
+ * @return True if parameters were loaded, false if the file couldn't be read, in which case tuning in effect is left unchanged.
+ */
+static inline bool
+load_tuning(const std::string& file_path)
+{
+  tuning_t tuning{};
+  if (!read_tuning(file_path, tuning)) {
+    return false;
+  }
+
+  set_tuning(tuning);
+  return true;
+}
+
+}
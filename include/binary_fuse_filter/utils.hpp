@@ -1,11 +1,22 @@
 #pragma once
+#include <algorithm>
 #include <array>
+#include <bit>
 #include <cmath>
+#include <cstddef>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
-#include <set>
+#include <memory>
 #include <span>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(__SSE2__)
+#include <immintrin.h>
+#endif
 
 namespace bff_kv_map_utils {
 
@@ -40,19 +51,16 @@ private:
 };
 
 // Checks if all keys in the given span are distinct. Returns true if all keys are unique, false otherwise.
+// Sorts a flat copy of keys and looks for equal neighbours, which is much faster than inserting them into a node-based set.
 static inline bool
 are_all_keys_distinct(std::span<const bff_key_t> keys)
 {
-  std::set<bff_key_t> s;
+  std::vector<bff_key_t> sorted_keys(keys.size());
+  std::copy(keys.begin(), keys.end(), sorted_keys.begin());
+  std::sort(sorted_keys.begin(), sorted_keys.end(), [](const bff_key_t& lhs, const bff_key_t& rhs) { return lhs.words < rhs.words; });
 
-  for (auto key : keys) {
-    auto [_, has_inserted] = s.insert(key);
-    if (!has_inserted) {
-      return false;
-    }
-  }
-
-  return true;
+  const auto it = std::adjacent_find(sorted_keys.begin(), sorted_keys.end(), [](const bff_key_t& lhs, const bff_key_t& rhs) { return lhs.words == rhs.words; });
+  return it == sorted_keys.end();
 }
 
 // Computes a 32-bit fingerprint from a 64-bit hash value.
@@ -141,6 +149,22 @@ mix256(std::span<const uint64_t, 4> key, std::span<const uint8_t, 32> seed)
   return mixed_outer;
 }
 
+// Derives the seed of a construction attempt, from the seed passed by the user. First attempt uses the seed as is, while later ones
+// tweak its first 64 -bit word, so that every attempt hashes keys differently.
+static inline std::array<uint8_t, 32>
+derive_seed(std::span<const uint8_t, 32> seed, const uint64_t attempt)
+{
+  std::array<uint8_t, 32> derived_seed{};
+  memcpy(derived_seed.data(), seed.data(), seed.size_bytes());
+
+  uint64_t word = 0;
+  memcpy(&word, derived_seed.data(), sizeof(word));
+  word ^= murmur64(attempt);
+  memcpy(derived_seed.data(), &word, sizeof(word));
+
+  return derived_seed;
+}
+
 // Computes the high 64 bits of the 128-bit product of two 64-bit integers.  This is used for 64-bit multiplication without overflow.
 static constexpr uint64_t
 mulhi(const uint64_t a, const uint64_t b)
@@ -176,4 +200,113 @@ mulhi(const uint64_t a, const uint64_t b)
 #endif
 }
 
+// Computes the three fingerprint slots of a key, given its 64-bit hash and segment layout of the filter. Slots fall within three consecutive segments.
+static constexpr std::tuple<uint32_t, uint32_t, uint32_t>
+hash_batch(const uint64_t hash, const uint32_t segment_length, const uint32_t segment_length_mask, const uint32_t segment_count_length)
+{
+  const uint64_t hi = mulhi(hash, segment_count_length);
+
+  uint32_t h0 = 0, h1 = 0, h2 = 0;
+
+  h0 = (uint32_t)hi;
+  h1 = h0 + segment_length;
+  h2 = h1 + segment_length;
+  h1 ^= (uint32_t)(hash >> 18U) & segment_length_mask;
+  h2 ^= (uint32_t)(hash) & segment_length_mask;
+
+  return { h0, h1, h2 };
+}
+
+// Whether a segment layout, read from serialized bytes, is consistent the way a filter lays out its segments, s.t. all three slots of any key, as
+// computed by `hash_batch`, fall within its `array_length` fingerprints.
+static constexpr bool
+is_consistent_segment_layout(const uint32_t segment_length, const uint32_t segment_count, const uint32_t segment_count_length, const uint32_t array_length)
+{
+  constexpr uint64_t arity = 3;
+  return std::has_single_bit(segment_length) && (segment_count != 0) &&
+         ((static_cast<uint64_t>(segment_count) * segment_length) == segment_count_length) &&
+         (((static_cast<uint64_t>(segment_count) + arity - 1) * segment_length) == array_length);
+}
+
+// Zeroes out given memory, s.t. the compiler can't elide it as a dead store, even when the memory is freed right after. The empty asm statement makes
+// the compiler assume zeroed bytes are read, while memset keeps wiping as fast as a regular fill. Empty spans may have a null data pointer, which must
+// not be passed to memset, so they're skipped.
+template<typename T, size_t extent>
+static inline void
+secure_wipe(std::span<T, extent> data)
+{
+  if (data.empty()) {
+    return;
+  }
+
+  std::memset(static_cast<void*>(data.data()), 0, data.size_bytes());
+  asm volatile("" : : "r"(data.data()) : "memory");
+}
+
+// Allocator, whose containers leave trivial elements uninitialized on resize, instead of zeroing them, so that scratch space is zeroed only once, by
+// `zero_fill`.
+template<typename T>
+struct default_init_allocator_t : std::allocator<T>
+{
+  template<typename U>
+  struct rebind
+  {
+    using other = default_init_allocator_t<U>;
+  };
+
+  using std::allocator<T>::allocator;
+
+  template<typename U>
+  void construct(U* const ptr) noexcept(std::is_nothrow_default_constructible_v<U>)
+  {
+    ::new (static_cast<void*>(ptr)) U;
+  }
+
+  template<typename U, typename... Args>
+  void construct(U* const ptr, Args&&... args)
+  {
+    std::construct_at(ptr, std::forward<Args>(args)...);
+  }
+};
+
+// Vector of construction scratch space, which is zeroed explicitly, by `zero_fill`.
+template<typename T>
+using scratch_vector_t = std::vector<T, default_init_allocator_t<T>>;
+
+// Zeroes out given memory, optionally with non-temporal stores, which write around caches, so that zeroing large scratch space doesn't evict cache
+// lines of other threads. Non-temporal stores are only used on x86_64, elsewhere it's a regular fill.
+template<typename T, size_t extent>
+static inline void
+zero_fill(std::span<T, extent> data, [[maybe_unused]] const bool non_temporal)
+{
+  if (data.empty()) {
+    return;
+  }
+
+#if defined(__SSE2__)
+  if (non_temporal) {
+    auto* bytes = reinterpret_cast<uint8_t*>(data.data());
+    size_t num_bytes = data.size_bytes();
+
+    // Bytes before the first 16B aligned address, and after the last one, are zeroed with regular stores.
+    const size_t num_head_bytes = std::min(num_bytes, (16 - (reinterpret_cast<uintptr_t>(bytes) % 16)) % 16);
+    std::memset(bytes, 0, num_head_bytes);
+    bytes += num_head_bytes;
+    num_bytes -= num_head_bytes;
+
+    const __m128i zero = _mm_setzero_si128();
+    for (; num_bytes >= 16; bytes += 16, num_bytes -= 16) {
+      _mm_stream_si128(reinterpret_cast<__m128i*>(bytes), zero);
+    }
+
+    std::memset(bytes, 0, num_bytes);
+    _mm_sfence();
+
+    return;
+  }
+#endif
+
+  std::memset(static_cast<void*>(data.data()), 0, data.size_bytes());
+}
+
 }
@@ -0,0 +1,142 @@
+#pragma once
+#include "filter_for_kv_map.hpp"
+#include "utils.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+namespace bff_kv_map {
+
+// Binary Fuse Filter for Key-Value Maps with wide values i.e. up to 64 -bit, which don't fit in [0, plaintext_modulo).
+// Each value is split into base-p limbs, which are stored side by side in each fingerprint slot. All limbs share the same fuse graph, so keys are
+// peeled only once during construction, and recovering a value needs a single key hash and three probes, each reading a contiguous group of limbs.
+struct bff_for_kv_map_wide_t : protected bff_for_kv_map_t
+{
+private:
+  uint32_t value_bit_width = 0;
+  uint32_t num_limbs = 0;
+
+public:
+  bff_for_kv_map_wide_t() = default;
+
+  /**
+   * @brief Construct a Binary Fuse Filter for Key-Value Map with wide values.
+   *
+   * @param seed_bytes The seed bytes to use.
+   * @param keys The keys of the Key-Value Map.
+   * @param values The values of the Key-Value Map s.t. value ∈ [0, 2^value_bit_width)
+   * @param plaintext_modulo The plaintext modulo to use, which is the base of limbs.
+   * @param label The label to use.
+   * @param value_bit_width Bit width of values, which determines the number of limbs per value.
+   */
+  explicit bff_for_kv_map_wide_t(std::span<const uint8_t, 32> seed_bytes,
+                                 std::span<const bff_kv_map_utils::bff_key_t> keys,
+                                 std::span<const uint64_t> values,
+                                 const uint64_t plaintext_modulo,
+                                 const uint64_t label,
+                                 const uint32_t value_bit_width = 64)
+  {
+    if (keys.size() != values.size()) [[unlikely]] {
+      throw std::runtime_error("Number of keys and values must be equal.");
+    }
+    if ((value_bit_width == 0) || (value_bit_width > 64)) [[unlikely]] {
+      throw std::runtime_error("Value bit width must be in [1, 64].");
+    }
+
+    const uint64_t max_value = (value_bit_width == 64) ? ~0UL : ((1UL << value_bit_width) - 1);
+    if (std::any_of(values.begin(), values.end(), [&](const uint64_t value) { return value > max_value; })) [[unlikely]] {
+      throw std::runtime_error("All values must fit in value bit width.");
+    }
+
+    auto peeling = layout_and_peel(seed_bytes, keys, plaintext_modulo, label, BFF_FOR_KV_MAP_MAX_SEGMENT_LENGTH, BFF_FOR_KV_MAP_MIN_SIZE_FACTOR, 0, 1, nullptr);
+
+    this->value_bit_width = value_bit_width;
+    this->num_limbs = 0;
+    for (uint64_t value_left = max_value; value_left > 0; value_left /= plaintext_modulo) {
+      this->num_limbs++;
+    }
+
+    fingerprints = std::vector<uint32_t>(static_cast<size_t>(array_length) * num_limbs, 0);
+
+    std::array<uint32_t, 5> h012{};
+    for (uint32_t i = peeling.num_peeled_keys - 1; i < peeling.num_peeled_keys; i--) {
+      const uint64_t hash = peeling.reverseOrder[i];
+      uint64_t value = values[peeling.hm_keys[hash]];
+
+      const auto [h0, h1, h2] = hash_batch(hash);
+
+      const uint8_t found = peeling.reverseH[i];
+      h012[0] = h0;
+      h012[1] = h1;
+      h012[2] = h2;
+      h012[3] = h012[0];
+      h012[4] = h012[1];
+
+      uint32_t* const limbs = fingerprints.data() + (static_cast<size_t>(h012[found]) * num_limbs);
+      const uint32_t* const other_limbs1 = fingerprints.data() + (static_cast<size_t>(h012[found + 1]) * num_limbs);
+      const uint32_t* const other_limbs2 = fingerprints.data() + (static_cast<size_t>(h012[found + 2]) * num_limbs);
+
+      for (uint32_t limb_idx = 0; limb_idx < num_limbs; limb_idx++) {
+        const auto limb = static_cast<uint32_t>(value % plaintext_modulo);
+        value /= plaintext_modulo;
+
+        const uint32_t entry = (limb - other_limbs1[limb_idx] - other_limbs2[limb_idx]) % plaintext_modulo;
+        const uint32_t mask = bff_kv_map_utils::mix(hash, label + limb_idx) % plaintext_modulo;
+
+        limbs[limb_idx] = (entry - mask) % plaintext_modulo;
+      }
+    }
+  }
+
+  using bff_for_kv_map_t::bits_per_entry;
+  using bff_for_kv_map_t::get_seed;
+
+  /**
+   * @brief Get the bit width of values.
+   *
+   * @return The value bit width.
+   */
+  uint32_t get_value_bit_width() const { return value_bit_width; }
+
+  /**
+   * @brief Get the number of base-p limbs, each value is split into.
+   *
+   * @return The number of limbs per value.
+   */
+  uint32_t get_num_limbs() const { return num_limbs; }
+
+  /**
+   * @brief Recover the wide value associated with a given key.
+   *
+   * @param key The key to query.
+   * @return The value associated with the key.
+   */
+  uint64_t recover64(const bff_kv_map_utils::bff_key_t key) const
+  {
+    const uint64_t hash = hash_key(key);
+    const auto [h0, h1, h2] = hash_batch(hash);
+
+    const uint32_t* const limbs0 = fingerprints.data() + (static_cast<size_t>(h0) * num_limbs);
+    const uint32_t* const limbs1 = fingerprints.data() + (static_cast<size_t>(h1) * num_limbs);
+    const uint32_t* const limbs2 = fingerprints.data() + (static_cast<size_t>(h2) * num_limbs);
+
+    uint64_t value = 0;
+    uint64_t limb_weight = 1;
+
+    for (uint32_t limb_idx = 0; limb_idx < num_limbs; limb_idx++) {
+      const uint32_t data = limbs0[limb_idx] + limbs1[limb_idx] + limbs2[limb_idx];
+      const uint32_t mask = bff_kv_map_utils::mix(hash, label + limb_idx) % plaintext_modulo;
+      const uint64_t limb = (data + mask) % plaintext_modulo;
+
+      value += limb * limb_weight;
+      limb_weight *= plaintext_modulo;
+    }
+
+    return value;
+  }
+};
+
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <array>
+#include <cstdint>
+
+// Regression vector for `serialize_as_bff_modp` and `from_bff_modp_bytes`, generated with this implementation. It pins the layout down against
+// accidental changes, but it is NOT verified against bytes produced by the Rust crate `bff-modp`, so it says nothing about compatibility with it.
+// A filter over these 16 keys and values, built with the given seed, plaintext modulo and label, must serialize to exactly `SERIALIZED_FILTER`.
+// Keys are defined as `murmur64(4 * i + j + 1)` for j-th word of i-th key, values as `(61 * i + 7) % 1024`, seed bytes as `i`.
+namespace bff_modp_regression_vector {
+
+constexpr uint64_t PLAINTEXT_MODULO = 1024;
+constexpr uint64_t LABEL = 42;
+
+constexpr std::array<uint8_t, 32> SEED = { 0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+                                           0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f };
+
+constexpr std::array<std::array<uint64_t, 4>, 16> KEYS = { {
+  { 0xb456bcfc34c2cb2cUL, 0x3abf2a20650683e7UL, 0x0b5181c509f8d8ceUL, 0x47900468a8f01875UL },
+  { 0xd66ad737d54c5575UL, 0xe8b4b3b1c77c4573UL, 0x740729cbe468d1ddUL, 0x46abcca593a3c687UL },
+  { 0x91209a1ff7f4f1d5UL, 0x646172442548d30dUL, 0xefc6be81a1d572c4UL, 0x88f52b3844a8b035UL },
+  { 0xe7be0c27d83d3145UL, 0xba2003bf0a4c771cUL, 0xd992eebb18cee22dUL, 0x5f694972d3c68944UL },
+  { 0xeb269b691ff3fb36UL, 0xf452e46763661434UL, 0xfec2978bc98e5299UL, 0x9ad494af841c8ae6UL },
+  { 0x39e2c19bbb925273UL, 0x971940d80d7ee737UL, 0xc77e76236bac4799UL, 0xc9761a44f8913a87UL },
+  { 0x7d0048afab056addUL, 0x8707dc23b1c9b4eeUL, 0x7ed3adb081e15aecUL, 0x8182fda86e799352UL },
+  { 0x194db9cd9a4dbc9fUL, 0xc068d3a0083b4330UL, 0x6e2bc9744ad1a8a9UL, 0xcc15890f1eee9f7dUL },
+  { 0x6e54cc947ba2590fUL, 0xe3902cfc25097b7aUL, 0x56fb21ec7a6401a9UL, 0xdb62d2a4df2fa55cUL },
+  { 0x55d5cc90aebe42e9UL, 0xf04238ed95ff2eceUL, 0x1a06cc8e7598e46cUL, 0x2866333606de98f9UL },
+  { 0xfc4ef1bca27d1ed3UL, 0x810879608e4259ccUL, 0x203ea4c5049ad615UL, 0x3b7577da105e355bUL },
+  { 0xac7840110d6a2541UL, 0x9c3fe26fde390827UL, 0x31060820874a0533UL, 0xa02f2ab2e843fa13UL },
+  { 0xcf8ffb89367b9db1UL, 0xecbd9b35dd54508eUL, 0xdbae4383c49f18ceUL, 0x00ccc21e64f2d4f1UL },
+  { 0xc6d3dbfc570ec78fUL, 0xf064653785232af3UL, 0xce2528ae22509919UL, 0xd517ab779d7c12e4UL },
+  { 0xd05a1a17297d914fUL, 0x04ad23c2ca0a3ca4UL, 0xdeafb5419e480cdaUL, 0x52e3576843d5e9a7UL },
+  { 0xa21020ed077865d6UL, 0x93e356bddfff2f27UL, 0x07628735893ad55cUL, 0x4fb6d5f3ab95cebeUL }
+} };
+
+constexpr std::array<uint32_t, 16> VALUES = { 7, 68, 129, 190, 251, 312, 373, 434, 495, 556, 617, 678, 739, 800, 861, 922 };
+
+constexpr std::array<uint8_t, 248> SERIALIZED_FILTER = {
+  0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+  0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f,
+  0x10, 0x00, 0x00, 0x00, 0x0f, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0x10, 0x00, 0x00, 0x00,
+  0x30, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x72, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x84, 0x02, 0x00, 0x00, 0x0c, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x98, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x6b, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x7e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf5, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa7, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x4a, 0x03, 0x00, 0x00, 0x0c, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0x00, 0x00, 0x00, 0x00, 0x2a, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xaa, 0x02, 0x00, 0x00,
+  0xeb, 0x03, 0x00, 0x00, 0xd9, 0x03, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+  0xc3, 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+}
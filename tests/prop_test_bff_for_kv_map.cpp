@@ -1,9 +1,19 @@
 #include "binary_fuse_filter/filter_for_kv_map.hpp"
 #include "binary_fuse_filter/utils.hpp"
+#include "bff_modp_regression_vectors.hpp"
 #include "test_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
 #include <cstring>
+#include <exception>
 #include <gtest/gtest.h>
 #include <stdexcept>
+#include <sys/resource.h>
+#include <thread>
+#include <type_traits>
 
 // Tests that a filter can be created, and that querying it with keys returns the correct values.
 TEST(BinaryFuseFilterForKVMap, CreateFilterAndRecoverValuesWhenQueriedUsingKeys)
@@ -67,6 +77,365 @@ TEST(BinaryFuseFilterForKVMap, SerializeAndDeserializeFilter)
   }
 }
 
+// Tests that filters are moved and swapped without being copied, leaving moved-from filters wiped, while implicit copies don't compile.
+TEST(BinaryFuseFilterForKVMap, MoveAndSwapFilters)
+{
+  static_assert(std::is_nothrow_move_constructible_v<bff_kv_map::bff_for_kv_map_t>);
+  static_assert(std::is_nothrow_move_assignable_v<bff_kv_map::bff_for_kv_map_t>);
+  static_assert(std::is_nothrow_swappable_v<bff_kv_map::bff_for_kv_map_t>);
+  static_assert(!std::is_copy_constructible_v<bff_kv_map::bff_for_kv_map_t>);
+  static_assert(!std::is_copy_assignable_v<bff_kv_map::bff_for_kv_map_t>);
+
+  constexpr size_t size = 10'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys_a(size), keys_b(size);
+  std::vector<uint32_t> values_a(size, 0), values_b(size, 0);
+  generate_random_keys_and_values(keys_a, values_a, plaintext_modulo);
+  generate_random_keys_and_values(keys_b, values_b, plaintext_modulo);
+
+  const auto is_wiped = [](const bff_kv_map::bff_for_kv_map_t& filter) {
+    const auto seed = filter.get_seed();
+    return std::all_of(seed.begin(), seed.end(), [](const uint8_t byte) { return byte == 0; }) &&
+           (filter.serialized_num_bytes() == bff_kv_map::bff_for_kv_map_t().serialized_num_bytes());
+  };
+
+  const auto recovers_all = [](const bff_kv_map::bff_for_kv_map_t& filter, const auto& keys, const auto& values) {
+    std::vector<uint32_t> recovered(keys.size(), 0);
+    return filter.recover_batch(keys, recovered) && (recovered == values);
+  };
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter_a(generate_random_seed(), keys_a, values_a, plaintext_modulo, label);
+    bff_kv_map::bff_for_kv_map_t filter_b(generate_random_seed(), keys_b, values_b, plaintext_modulo, label);
+
+    const auto seed_a = filter_a.get_seed();
+
+    bff_kv_map::bff_for_kv_map_t moved_filter(std::move(filter_a));
+    EXPECT_TRUE(is_wiped(filter_a));
+    EXPECT_EQ(moved_filter.get_seed(), seed_a);
+    EXPECT_TRUE(recovers_all(moved_filter, keys_a, values_a));
+
+    moved_filter = std::move(filter_b);
+    EXPECT_TRUE(is_wiped(filter_b));
+    EXPECT_TRUE(recovers_all(moved_filter, keys_b, values_b));
+
+    filter_a = bff_kv_map::bff_for_kv_map_t(seed_a, keys_a, values_a, plaintext_modulo, label);
+    swap(filter_a, moved_filter);
+    EXPECT_TRUE(recovers_all(filter_a, keys_b, values_b));
+    EXPECT_TRUE(recovers_all(moved_filter, keys_a, values_a));
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that speculative construction results in the same filter as serial construction, when early attempts fail. Keys and seed are fixed, s.t.
+// attempts 0 and 1 fail to peel, while attempts 2 and 3, which are raced alongside them, both succeed, so the lowest indexed successful attempt
+// must win, over later ones, which are cancelled or discarded. Serial construction of this many keys takes the compact path.
+TEST(BinaryFuseFilterForKVMap, SpeculativeConstructionMatchesSerialConstruction)
+{
+  constexpr size_t size = 10'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+  constexpr size_t num_speculative_attempts = 4;
+  // Found offline, by trying seeds until serial construction over the keys below needed a third attempt.
+  constexpr size_t winning_attempt = 2;
+  constexpr std::array<uint8_t, 32> seed = { 0xea, 0x03, 0x00, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+                                             0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f };
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  for (size_t i = 0; i < size; i++) {
+    for (size_t j = 0; j < keys[i].words.size(); j++) {
+      keys[i].words[j] = bff_kv_map_utils::murmur64((4 * i) + j + 1);
+    }
+    values[i] = static_cast<uint32_t>(((61 * i) + 7) % plaintext_modulo);
+  }
+
+  bff_kv_map::bff_for_kv_map_t serial_filter(seed, keys, values, plaintext_modulo, label);
+  bff_kv_map::bff_for_kv_map_t speculative_filter(seed, keys, values, plaintext_modulo, label, num_speculative_attempts);
+
+  EXPECT_EQ(serial_filter.get_seed(), bff_kv_map_utils::derive_seed(seed, winning_attempt));
+  EXPECT_EQ(speculative_filter.get_seed(), bff_kv_map_utils::derive_seed(seed, winning_attempt));
+
+  std::vector<uint8_t> serial_filter_as_bytes(serial_filter.serialized_num_bytes());
+  std::vector<uint8_t> speculative_filter_as_bytes(speculative_filter.serialized_num_bytes());
+
+  EXPECT_TRUE(serial_filter.serialize(serial_filter_as_bytes));
+  EXPECT_TRUE(speculative_filter.serialize(speculative_filter_as_bytes));
+  EXPECT_EQ(serial_filter_as_bytes, speculative_filter_as_bytes);
+
+  for (size_t i = 0; i < size; i++) {
+    const uint32_t recovered = speculative_filter.recover(keys[i]);
+    EXPECT_EQ(values[i], recovered);
+  }
+}
+
+// Tests that an exception thrown by a speculative construction attempt, on its worker thread, reaches the caller, instead of terminating the process.
+// In a child process, address space is limited s.t. there's room for keys and worker stacks, but not for scratch space of all raced attempts.
+TEST(BinaryFuseFilterForKVMap, SpeculativeConstructionRethrowsExceptionOfAttempt)
+{
+#if defined(__SANITIZE_ADDRESS__)
+  GTEST_SKIP() << "Address Sanitizer reserves far more address space than can be limited.";
+#else
+  constexpr size_t size = 1'000'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+  constexpr size_t num_speculative_attempts = 4;
+  constexpr size_t address_space_headroom = 192UL << 20;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  const auto construct_within_limited_address_space = [&]() {
+    const rlimit limit{ (read_proc_self_status_field("VmSize") << 10) + address_space_headroom, RLIM_INFINITY };
+    setrlimit(RLIMIT_AS, &limit);
+
+    try {
+      bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label, num_speculative_attempts);
+    } catch (const std::exception&) {
+      // Mostly `std::bad_alloc`, thrown by a worker, though creating a worker may fail too, when its stack doesn't fit.
+      std::_Exit(0);
+    }
+    std::_Exit(1);
+  };
+
+  // The child re-executes the test binary, running only this test, so that memory freed by earlier tests isn't around for attempts to reuse.
+  GTEST_FLAG_SET(death_test_style, "threadsafe");
+  EXPECT_EXIT(construct_within_limited_address_space(), testing::ExitedWithCode(0), "");
+#endif
+}
+
+// Tests that constructing in background, within a build budget, results in the same filter, as constructing flat out.
+TEST(BinaryFuseFilterForKVMap, BackgroundConstructionMatchesRegularConstruction)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t regular_filter(seed, keys, values, plaintext_modulo, label);
+
+    std::vector<uint8_t> regular_filter_as_bytes(regular_filter.serialized_num_bytes());
+    EXPECT_TRUE(regular_filter.serialize(regular_filter_as_bytes));
+
+    for (const auto budget : { bff_kv_map::build_budget_t{ .cpu_fraction = 0.5, .max_num_threads = 1, .use_non_temporal_stores = true },
+                               bff_kv_map::build_budget_t{ .cpu_fraction = 1., .max_num_threads = 2, .use_non_temporal_stores = false },
+                               bff_kv_map::build_budget_t{ .cpu_fraction = 0.25, .max_num_threads = 4, .use_non_temporal_stores = true } }) {
+      bff_kv_map::bff_for_kv_map_t background_filter(seed, keys, values, plaintext_modulo, label, budget);
+
+      std::vector<uint8_t> background_filter_as_bytes(background_filter.serialized_num_bytes());
+      EXPECT_TRUE(background_filter.serialize(background_filter_as_bytes));
+      EXPECT_EQ(regular_filter_as_bytes, background_filter_as_bytes);
+
+      for (size_t i = 0; i < size; i++) {
+        const uint32_t recovered = background_filter.recover(keys[i]);
+        EXPECT_EQ(values[i], recovered);
+      }
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that a build throttle, checkpointed after running for a while, sleeps long enough to have run for no more than its budgeted fraction of time,
+// while without a budget, it doesn't sleep.
+TEST(BinaryFuseFilterForKVMap, BuildThrottleSleepsToStayWithinCPUFraction)
+{
+  constexpr auto busy_for = std::chrono::milliseconds(20);
+  constexpr bff_kv_map::build_budget_t budget{ .cpu_fraction = 0.25, .max_num_threads = 1, .use_non_temporal_stores = false };
+
+  const auto checkpoint_after_running_for = [&](const bff_kv_map::build_budget_t* const budget) {
+    bff_kv_map::build_throttle_t throttle(budget);
+
+    const auto busy_until = std::chrono::steady_clock::now() + busy_for;
+    while (std::chrono::steady_clock::now() < busy_until) {
+    }
+
+    const auto checkpoint_at = std::chrono::steady_clock::now();
+    throttle.checkpoint();
+    return std::chrono::steady_clock::now() - checkpoint_at;
+  };
+
+  // Running for a quarter of the time, the throttle must idle for three times as long as it ran.
+  EXPECT_GE(checkpoint_after_running_for(&budget), busy_for * 3);
+  EXPECT_LT(checkpoint_after_running_for(nullptr), busy_for);
+}
+
+// Tests that construction within a build budget starts on the calling thread alone, and never runs on more threads than the budget allows, even when
+// later attempts are raced. Keys and seed are those of `SpeculativeConstructionMatchesSerialConstruction`, s.t. the first two attempts fail.
+// Threads of the process are sampled while constructing, so an exceeded cap may go unnoticed, but a respected one never fails the test.
+TEST(BinaryFuseFilterForKVMap, BackgroundConstructionRespectsThreadCap)
+{
+  constexpr size_t size = 10'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+  constexpr size_t winning_attempt = 2;
+  constexpr std::array<uint8_t, 32> seed = { 0xea, 0x03, 0x00, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x0e, 0x0f,
+                                             0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f };
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  for (size_t i = 0; i < size; i++) {
+    for (size_t j = 0; j < keys[i].words.size(); j++) {
+      keys[i].words[j] = bff_kv_map_utils::murmur64((4 * i) + j + 1);
+    }
+    values[i] = static_cast<uint32_t>(((61 * i) + 7) % plaintext_modulo);
+  }
+
+  // Returns the largest number of threads, the process ran on while constructing, on top of those running before.
+  const auto num_extra_threads_while_constructing = [&](std::span<const uint8_t, 32> seed_bytes, const bff_kv_map::build_budget_t& budget) {
+    std::atomic<bool> is_constructing{ true };
+    size_t max_num_threads = 0;
+
+    std::jthread sampler([&]() {
+      while (is_constructing.load(std::memory_order_relaxed)) {
+        max_num_threads = std::max(max_num_threads, read_proc_self_status_field("Threads"));
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+      }
+    });
+
+    const size_t num_threads_before = read_proc_self_status_field("Threads");
+    bff_kv_map::bff_for_kv_map_t filter(seed_bytes, keys, values, plaintext_modulo, label, budget);
+
+    is_constructing.store(false, std::memory_order_relaxed);
+    sampler.join();
+
+    EXPECT_EQ(filter.get_seed(), bff_kv_map_utils::derive_seed(seed, winning_attempt));
+    for (size_t i = 0; i < size; i++) {
+      EXPECT_EQ(values[i], filter.recover(keys[i]));
+    }
+
+    return (max_num_threads > num_threads_before) ? (max_num_threads - num_threads_before) : 0;
+  };
+
+  constexpr bff_kv_map::build_budget_t budget{ .cpu_fraction = 0.25, .max_num_threads = 2, .use_non_temporal_stores = true };
+  EXPECT_LE(num_extra_threads_while_constructing(seed, budget), budget.max_num_threads);
+
+  // Starting from the seed of the winning attempt, the first attempt, which uses it as is, peels. So construction never leaves the calling thread.
+  const auto winning_seed = bff_kv_map_utils::derive_seed(seed, winning_attempt);
+  constexpr bff_kv_map::build_budget_t generous_budget{ .cpu_fraction = 0.25, .max_num_threads = 4, .use_non_temporal_stores = true };
+  EXPECT_EQ(num_extra_threads_while_constructing(winning_seed, generous_budget), 0UL);
+}
+
+// Tests that small filters, built serially on the compact construction path, are the same as those built on the regular path, which speculative
+// construction always takes.
+TEST(BinaryFuseFilterForKVMap, CompactConstructionMatchesRegularConstruction)
+{
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+  constexpr size_t num_speculative_attempts = 2;
+
+  for (const size_t size : { 1UL, 2UL, 100UL, 1'000UL, 16'000UL, 50'000UL, 65'536UL }) {
+    auto seed = generate_random_seed();
+    std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+    std::vector<uint32_t> values(size, 0);
+    generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+    try {
+      bff_kv_map::bff_for_kv_map_t compact_filter(seed, keys, values, plaintext_modulo, label);
+      bff_kv_map::bff_for_kv_map_t regular_filter(seed, keys, values, plaintext_modulo, label, num_speculative_attempts);
+
+      EXPECT_EQ(compact_filter.get_seed(), regular_filter.get_seed());
+
+      std::vector<uint8_t> compact_filter_as_bytes(compact_filter.serialized_num_bytes());
+      std::vector<uint8_t> regular_filter_as_bytes(regular_filter.serialized_num_bytes());
+
+      EXPECT_TRUE(compact_filter.serialize(compact_filter_as_bytes));
+      EXPECT_TRUE(regular_filter.serialize(regular_filter_as_bytes));
+      EXPECT_EQ(compact_filter_as_bytes, regular_filter_as_bytes);
+
+      for (size_t i = 0; i < size; i++) {
+        const uint32_t recovered = compact_filter.recover(keys[i]);
+        EXPECT_EQ(values[i], recovered);
+      }
+    } catch (std::runtime_error& err) {
+      constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+      const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+      EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+    }
+  }
+}
+
+// Tests that a filter can be serialized in, and deserialized from, the layout of Rust crate `bff-modp`, and that querying it with keys returns the
+// correct values, while truncated or inconsistent bytes, or a too small plaintext modulo, are rejected.
+TEST(BinaryFuseFilterForKVMap, SerializeAndDeserializeFilterInBffModpLayout)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+    std::vector<uint8_t> filter_as_bytes(filter.bff_modp_serialized_num_bytes());
+    EXPECT_TRUE(filter.serialize_as_bff_modp(filter_as_bytes));
+
+    const auto filter_from_bytes = bff_kv_map::bff_for_kv_map_t::from_bff_modp_bytes(filter_as_bytes, size, plaintext_modulo, label);
+
+    for (size_t i = 0; i < size; i++) {
+      EXPECT_EQ(values[i], filter_from_bytes.recover(keys[i]));
+    }
+
+    std::vector<uint8_t> truncated_filter_as_bytes(filter_as_bytes.begin(), filter_as_bytes.end() - sizeof(uint32_t));
+    EXPECT_THROW(bff_kv_map::bff_for_kv_map_t::from_bff_modp_bytes(truncated_filter_as_bytes, size, plaintext_modulo, label), std::runtime_error);
+    EXPECT_THROW(bff_kv_map::bff_for_kv_map_t::from_bff_modp_bytes(filter_as_bytes, size, 0, label), std::runtime_error);
+
+    // Segment count follows seed, segment length and its mask. Growing it would have probes fall beyond fingerprints.
+    std::vector<uint8_t> corrupted_filter_as_bytes(filter_as_bytes);
+    corrupted_filter_as_bytes[filter.get_seed().size() + 2 * sizeof(uint32_t)] += 1;
+    EXPECT_THROW(bff_kv_map::bff_for_kv_map_t::from_bff_modp_bytes(corrupted_filter_as_bytes, size, plaintext_modulo, label), std::runtime_error);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests against a regression vector, generated with this implementation, that serialization in the `bff-modp` layout doesn't change, and that
+// filters deserialized from it recover the expected values when queried using keys. Compatibility with the Rust crate itself is unverified.
+TEST(BinaryFuseFilterForKVMap, BffModpLayoutRegressionVector)
+{
+  using namespace bff_modp_regression_vector;
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(KEYS.size());
+  for (size_t i = 0; i < KEYS.size(); i++) {
+    keys[i].words = KEYS[i];
+  }
+
+  bff_kv_map::bff_for_kv_map_t filter(SEED, keys, VALUES, PLAINTEXT_MODULO, LABEL);
+
+  std::vector<uint8_t> filter_as_bytes(filter.bff_modp_serialized_num_bytes());
+  EXPECT_TRUE(filter.serialize_as_bff_modp(filter_as_bytes));
+  EXPECT_TRUE(std::ranges::equal(filter_as_bytes, SERIALIZED_FILTER));
+
+  const auto filter_from_bytes = bff_kv_map::bff_for_kv_map_t::from_bff_modp_bytes(SERIALIZED_FILTER, keys.size(), PLAINTEXT_MODULO, LABEL);
+  for (size_t i = 0; i < keys.size(); i++) {
+    EXPECT_EQ(VALUES[i], filter_from_bytes.recover(keys[i]));
+  }
+}
+
 // Tests that the bits-per-entry is less than the theoretical maximum. The theoretical maximum is log2(plaintext_modulo) + 2.
 // This test is inspired by https://github.com/claucece/chalamet/blob/515ff1479940a2917ad247acb6ab9e6d27e139a1/bff-modp/src/bfusep32.rs#L158-L173.
 TEST(BinaryFuseFilterForKVMap, CheckBitsPerEntry)
@@ -165,3 +534,30 @@ TEST(BinaryFuseFilterForKVMap, AttemptConstructionWithPlainTextModuloLesserThan2
     EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
   }
 }
+
+// Tests that attempting to construct a filter in background, with a build budget allowing no CPU time or no thread, throws an exception.
+TEST(BinaryFuseFilterForKVMap, AttemptBackgroundConstructionWithInvalidBuildBudget)
+{
+  constexpr size_t size = 1'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  for (const auto budget : { bff_kv_map::build_budget_t{ .cpu_fraction = 0., .max_num_threads = 1 },
+                             bff_kv_map::build_budget_t{ .cpu_fraction = 1.5, .max_num_threads = 1 },
+                             bff_kv_map::build_budget_t{ .cpu_fraction = 0.5, .max_num_threads = 0 } }) {
+    try {
+      bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label, budget);
+      EXPECT_TRUE(false);
+    } catch (std::runtime_error& err) {
+      constexpr auto expected_err_msg = "Build budget must allow a CPU fraction in (0, 1], on at least one thread.";
+      const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+      EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+    }
+  }
+}
@@ -0,0 +1,122 @@
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/filter_set_for_kv_map.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+// Tests that many filters can be added to a filter set, and that querying it with handles and keys returns the correct values.
+TEST(BinaryFuseFilterForKVMapSet, AddFiltersAndRecoverValuesWhenQueriedUsingHandlesAndKeys)
+{
+  constexpr size_t num_filters = 1'000;
+  constexpr size_t max_size = 200;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  bff_kv_map::bff_for_kv_map_set_t filter_set;
+
+  std::vector<std::vector<bff_kv_map_utils::bff_key_t>> keys(num_filters);
+  std::vector<std::vector<uint32_t>> values(num_filters);
+  std::vector<uint32_t> handles(num_filters);
+
+  for (size_t filter_idx = 0; filter_idx < num_filters; filter_idx++) {
+    const size_t size = 1 + (filter_idx % max_size);
+
+    auto seed = generate_random_seed();
+    keys[filter_idx] = std::vector<bff_kv_map_utils::bff_key_t>(size);
+    values[filter_idx] = std::vector<uint32_t>(size, 0);
+    generate_random_keys_and_values(keys[filter_idx], values[filter_idx], plaintext_modulo);
+
+    handles[filter_idx] = filter_set.add(seed, keys[filter_idx], values[filter_idx], plaintext_modulo, label + filter_idx);
+  }
+
+  EXPECT_EQ(filter_set.size(), num_filters);
+
+  for (size_t filter_idx = 0; filter_idx < num_filters; filter_idx++) {
+    for (size_t i = 0; i < keys[filter_idx].size(); i++) {
+      const uint32_t recovered = filter_set.recover(handles[filter_idx], keys[filter_idx][i]);
+      EXPECT_EQ(values[filter_idx][i], recovered);
+    }
+  }
+}
+
+// Tests that a filter, too large to be packed in a shared slab, recovers the same values from the set, as it does standalone.
+TEST(BinaryFuseFilterForKVMapSet, AddLargeFilterAndRecoverValuesWhenQueriedUsingKeys)
+{
+  constexpr size_t size = 1'000'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+    bff_kv_map::bff_for_kv_map_set_t filter_set;
+    const uint32_t small_filter_handle = filter_set.add(seed, std::span(keys).first(1), std::span(values).first(1), plaintext_modulo, label);
+    const uint32_t large_filter_handle = filter_set.add(filter);
+
+    EXPECT_EQ(filter_set.recover(small_filter_handle, keys[0]), values[0]);
+    for (size_t i = 0; i < size; i++) {
+      EXPECT_EQ(filter_set.recover(large_filter_handle, keys[i]), filter.recover(keys[i]));
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that moving a filter set hands its slabs over, s.t. handles issued by the source keep recovering the correct values from the destination.
+TEST(BinaryFuseFilterForKVMapSet, MoveFilterSets)
+{
+  static_assert(std::is_nothrow_move_constructible_v<bff_kv_map::bff_for_kv_map_set_t>);
+  static_assert(std::is_nothrow_move_assignable_v<bff_kv_map::bff_for_kv_map_set_t>);
+  static_assert(std::is_nothrow_swappable_v<bff_kv_map::bff_for_kv_map_set_t>);
+  static_assert(!std::is_copy_constructible_v<bff_kv_map::bff_for_kv_map_set_t>);
+  static_assert(!std::is_copy_assignable_v<bff_kv_map::bff_for_kv_map_set_t>);
+
+  constexpr size_t num_filters = 100;
+  constexpr size_t size = 100;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  std::vector<std::vector<bff_kv_map_utils::bff_key_t>> keys(num_filters, std::vector<bff_kv_map_utils::bff_key_t>(size));
+  std::vector<std::vector<uint32_t>> values(num_filters, std::vector<uint32_t>(size, 0));
+  std::vector<uint32_t> handles(num_filters);
+
+  bff_kv_map::bff_for_kv_map_set_t filter_set;
+  for (size_t filter_idx = 0; filter_idx < num_filters; filter_idx++) {
+    generate_random_keys_and_values(keys[filter_idx], values[filter_idx], plaintext_modulo);
+    handles[filter_idx] = filter_set.add(generate_random_seed(), keys[filter_idx], values[filter_idx], plaintext_modulo, label);
+  }
+
+  const auto recovers_all = [&](const bff_kv_map::bff_for_kv_map_set_t& set) {
+    for (size_t filter_idx = 0; filter_idx < num_filters; filter_idx++) {
+      for (size_t i = 0; i < size; i++) {
+        if (set.recover(handles[filter_idx], keys[filter_idx][i]) != values[filter_idx][i]) {
+          return false;
+        }
+      }
+    }
+
+    return true;
+  };
+
+  bff_kv_map::bff_for_kv_map_set_t moved_filter_set(std::move(filter_set));
+  EXPECT_EQ(filter_set.size(), 0UL);
+  EXPECT_EQ(moved_filter_set.size(), num_filters);
+  EXPECT_TRUE(recovers_all(moved_filter_set));
+
+  filter_set = std::move(moved_filter_set);
+  EXPECT_EQ(moved_filter_set.size(), 0UL);
+  EXPECT_EQ(filter_set.size(), num_filters);
+  EXPECT_TRUE(recovers_all(filter_set));
+}
@@ -0,0 +1,169 @@
+#include "binary_fuse_filter/filter_cache_for_kv_map.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+
+// Keys, values and serialized bytes of a filter, which a cache loads on demand.
+struct serialized_filter_t
+{
+  std::vector<bff_kv_map_utils::bff_key_t> keys;
+  std::vector<uint32_t> values;
+  std::vector<uint8_t> bytes;
+};
+
+// Builds and serializes given number of filters, each over given number of keys.
+static std::vector<serialized_filter_t>
+generate_serialized_filters(const size_t num_filters, const size_t num_keys_per_filter, const uint64_t plaintext_modulo, const uint64_t label)
+{
+  std::vector<serialized_filter_t> serialized_filters(num_filters);
+
+  for (auto& serialized_filter : serialized_filters) {
+    serialized_filter.keys = std::vector<bff_kv_map_utils::bff_key_t>(num_keys_per_filter);
+    serialized_filter.values = std::vector<uint32_t>(num_keys_per_filter, 0);
+    generate_random_keys_and_values(serialized_filter.keys, serialized_filter.values, plaintext_modulo);
+
+    bff_kv_map::bff_for_kv_map_t filter(generate_random_seed(), serialized_filter.keys, serialized_filter.values, plaintext_modulo, label);
+
+    serialized_filter.bytes = std::vector<uint8_t>(filter.serialized_num_bytes());
+    filter.serialize(serialized_filter.bytes);
+  }
+
+  return serialized_filters;
+}
+
+// Tests that values are recovered correctly from filters fetched through a cache, while resident filters never exceed its memory budget.
+TEST(BinaryFuseFilterCacheForKVMap, RecoverValuesThroughCacheWithinMemoryBudget)
+{
+  constexpr size_t num_filters = 16;
+  constexpr size_t num_keys_per_filter = 1'000;
+  constexpr size_t max_num_resident_filters = 4;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  try {
+    const auto serialized_filters = generate_serialized_filters(num_filters, num_keys_per_filter, plaintext_modulo, label);
+    const size_t max_num_bytes = max_num_resident_filters * serialized_filters[0].bytes.size();
+
+    std::atomic<size_t> num_loads{ 0 };
+    bff_kv_map::bff_for_kv_map_cache_t cache(max_num_bytes, [&](const uint64_t filter_id) {
+      num_loads.fetch_add(1);
+      return serialized_filters[filter_id].bytes;
+    });
+
+    for (size_t round = 0; round < 4; round++) {
+      for (size_t filter_id = 0; filter_id < num_filters; filter_id++) {
+        const auto filter = cache.get(filter_id);
+        const auto& serialized_filter = serialized_filters[filter_id];
+
+        for (size_t i = 0; i < num_keys_per_filter; i++) {
+          EXPECT_EQ(serialized_filter.values[i], filter->recover(serialized_filter.keys[i]));
+        }
+
+        EXPECT_LE(cache.num_resident_bytes(), max_num_bytes);
+        EXPECT_LE(cache.num_resident_filters(), max_num_resident_filters);
+      }
+    }
+
+    // Cycling through more filters than fit, evicts each one before it's requested again.
+    EXPECT_EQ(num_loads.load(), 4 * num_filters);
+    EXPECT_EQ(cache.num_misses(), 4 * num_filters);
+
+    // Filters requested repeatedly stay resident.
+    for (size_t round = 0; round < 4; round++) {
+      for (size_t filter_id = 0; filter_id < max_num_resident_filters; filter_id++) {
+        EXPECT_EQ(cache.get(filter_id)->recover(serialized_filters[filter_id].keys[0]), serialized_filters[filter_id].values[0]);
+      }
+    }
+
+    EXPECT_LE(num_loads.load(), 4 * num_filters + max_num_resident_filters);
+    EXPECT_GE(cache.num_hits(), 3 * max_num_resident_filters);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that concurrent and prefetched requests for a filter, which is being loaded, are coalesced into a single load.
+TEST(BinaryFuseFilterCacheForKVMap, CoalesceConcurrentRequestsForSameFilter)
+{
+  constexpr size_t num_filters = 2;
+  constexpr size_t num_keys_per_filter = 1'000;
+  constexpr size_t num_querying_threads = 8;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  try {
+    const auto serialized_filters = generate_serialized_filters(num_filters, num_keys_per_filter, plaintext_modulo, label);
+
+    std::atomic<size_t> num_loads{ 0 };
+    bff_kv_map::bff_for_kv_map_cache_t cache(
+      num_filters * serialized_filters[0].bytes.size(),
+      [&](const uint64_t filter_id) {
+        num_loads.fetch_add(1);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        return serialized_filters[filter_id].bytes;
+      },
+      2);
+
+    {
+      std::vector<std::jthread> querying_threads;
+      for (size_t thread_idx = 0; thread_idx < num_querying_threads; thread_idx++) {
+        querying_threads.emplace_back([&]() {
+          const auto filter = cache.get(0);
+          EXPECT_EQ(filter->recover(serialized_filters[0].keys[0]), serialized_filters[0].values[0]);
+        });
+      }
+    }
+
+    EXPECT_EQ(num_loads.load(), 1);
+
+    cache.prefetch(1);
+    cache.prefetch(1);
+    const auto filter_future = cache.get_async(1);
+    const auto filter = cache.get(1);
+
+    EXPECT_EQ(filter, filter_future.get());
+    EXPECT_EQ(filter->recover(serialized_filters[1].keys[0]), serialized_filters[1].values[0]);
+    EXPECT_EQ(num_loads.load(), 2);
+    EXPECT_EQ(cache.num_resident_filters(), 2);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that a failed load surfaces its exception to every request waiting for it, and isn't cached.
+TEST(BinaryFuseFilterCacheForKVMap, AttemptLoadingMissingFilter)
+{
+  std::atomic<size_t> num_loads{ 0 };
+  bff_kv_map::bff_for_kv_map_cache_t cache(1UL << 20, [&](const uint64_t) -> std::vector<uint8_t> {
+    num_loads.fetch_add(1);
+    throw std::runtime_error("Filter doesn't exist.");
+  });
+
+  for (size_t attempt = 0; attempt < 2; attempt++) {
+    try {
+      const auto filter = cache.get(0);
+      EXPECT_TRUE(false);
+    } catch (std::runtime_error& err) {
+      constexpr auto expected_err_msg = "Filter doesn't exist.";
+      const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+      EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+    }
+  }
+
+  EXPECT_EQ(num_loads.load(), 2);
+  EXPECT_EQ(cache.num_resident_filters(), 0);
+}
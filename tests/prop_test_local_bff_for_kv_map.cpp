@@ -0,0 +1,138 @@
+#include "binary_fuse_filter/local_filter_for_kv_map.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <type_traits>
+
+// Tests that a cache- and TLB-local filter can be created, and that querying it with keys returns the correct values, including stashed keys.
+TEST(LocalBinaryFuseFilterForKVMap, CreateFilterAndRecoverValuesWhenQueriedUsingKeys)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_local_t filter(seed, keys, values, plaintext_modulo, label);
+    EXPECT_LE(filter.stash_size(), std::max(bff_kv_map::BFF_FOR_KV_MAP_MIN_UNPEELED_KEY_COUNT, size / bff_kv_map::BFF_FOR_KV_MAP_KEYS_PER_UNPEELED_KEY));
+
+    for (size_t i = 0; i < size; i++) {
+      const uint32_t recovered = filter.recover(keys[i]);
+      EXPECT_EQ(values[i], recovered);
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that probes of a key fall within a window spanning at most two 4KB pages.
+TEST(LocalBinaryFuseFilterForKVMap, ProbesOfKeyFallWithinSmallWindow)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_local_t filter(seed, keys, values, plaintext_modulo, label);
+
+    for (size_t i = 0; i < size; i++) {
+      const auto hash_evals = filter.get_hash_evals(keys[i]);
+      if (!hash_evals.has_value()) {
+        continue;
+      }
+
+      const auto [h0, h1, h2] = *hash_evals;
+      EXPECT_LT((h2 - h0) * sizeof(uint32_t), 3 * bff_kv_map::BFF_FOR_KV_MAP_LOCAL_MAX_SEGMENT_LENGTH * sizeof(uint32_t));
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that a cache- and TLB-local filter can be serialized and deserialized, along with its stash.
+TEST(LocalBinaryFuseFilterForKVMap, SerializeAndDeserializeFilter)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_local_t filter(seed, keys, values, plaintext_modulo, label);
+
+    std::vector<uint8_t> filter_as_bytes(filter.serialized_num_bytes());
+    EXPECT_TRUE(filter.serialize(filter_as_bytes));
+
+    bff_kv_map::bff_for_kv_map_local_t filter_from_bytes(filter_as_bytes);
+    EXPECT_EQ(filter.stash_size(), filter_from_bytes.stash_size());
+
+    for (size_t i = 0; i < size; i++) {
+      EXPECT_EQ(values[i], filter_from_bytes.recover(keys[i]));
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that batched recovery from a cache- and TLB-local filter looks up stashed keys, and that the filter can't be used as a `bff_for_kv_map_t`,
+// whose members don't know about the stash.
+TEST(LocalBinaryFuseFilterForKVMap, RecoverBatchIncludingStashedKeys)
+{
+  static_assert(!std::is_convertible_v<const bff_kv_map::bff_for_kv_map_local_t&, const bff_kv_map::bff_for_kv_map_t&>);
+
+  constexpr size_t size = 100'000;
+  constexpr size_t max_num_attempts = 16;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    // Only a few keys are stashed at this size, sometimes none, so seeds are retried until some are.
+    bff_kv_map::bff_for_kv_map_local_t filter;
+    for (size_t attempt = 0; (attempt < max_num_attempts) && (filter.stash_size() == 0); attempt++) {
+      filter = bff_kv_map::bff_for_kv_map_local_t(generate_random_seed(), keys, values, plaintext_modulo, label);
+    }
+    EXPECT_GT(filter.stash_size(), 0);
+
+    std::vector<uint32_t> recovered(size, 0);
+    EXPECT_TRUE(filter.recover_batch(keys, recovered));
+    EXPECT_EQ(recovered, values);
+
+    const size_t num_stashed_keys =
+      static_cast<size_t>(std::count_if(keys.begin(), keys.end(), [&](const auto& key) { return !filter.get_hash_evals(key).has_value(); }));
+    EXPECT_EQ(num_stashed_keys, filter.stash_size());
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
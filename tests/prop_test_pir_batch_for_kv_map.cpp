@@ -0,0 +1,153 @@
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/pir_batch_for_kv_map.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+// Tests that batches of keys are assigned to distinct buckets, among their candidates, each holding all three slots of its key, and that values
+// recovered from answers of a single server pass are the same as those recovered from the filter.
+TEST(PIRBatchForKVMap, AnswerBatchesOfKeysInOneServerPass)
+{
+  constexpr size_t size = 100'000;
+  constexpr size_t batch_size = 8;
+  constexpr size_t num_batches = 100;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+    bff_kv_map::bff_for_kv_map_pir_batch_t pir_batch(filter, batch_size * 3);
+
+    const auto fingerprints_mod_p = filter.get_fingerprints_mod_p();
+    EXPECT_GE(pir_batch.query_num_elements(), fingerprints_mod_p.size());
+
+    std::vector<std::array<uint32_t, 3>> hash_evals(batch_size);
+    std::vector<uint64_t> key_fingerprints(batch_size);
+    std::vector<uint32_t> key_of_bucket(pir_batch.num_buckets());
+    std::vector<uint32_t> batch_query(pir_batch.query_num_elements());
+    std::vector<uint32_t> answers(pir_batch.num_buckets());
+    std::vector<uint32_t> recovered(batch_size);
+
+    size_t num_assigned_batches = 0;
+
+    for (size_t batch_idx = 0; batch_idx < num_batches; batch_idx++) {
+      const auto batch_keys = std::span(keys).subspan(batch_idx * batch_size, batch_size);
+      const auto batch_values = std::span(values).subspan(batch_idx * batch_size, batch_size);
+
+      for (size_t i = 0; i < batch_size; i++) {
+        hash_evals[i] = filter.get_hash_evals(batch_keys[i]);
+        key_fingerprints[i] = filter.get_key_fingerprint(batch_keys[i]);
+      }
+
+      if (!pir_batch.assign(hash_evals, key_of_bucket)) {
+        continue;
+      }
+      num_assigned_batches++;
+
+      std::vector<size_t> num_buckets_of_key(batch_size, 0);
+      for (size_t bucket = 0; bucket < pir_batch.num_buckets(); bucket++) {
+        const auto key = key_of_bucket[bucket];
+        if (key == bff_kv_map::BFF_FOR_KV_MAP_PIR_NO_KEY) {
+          continue;
+        }
+
+        num_buckets_of_key[key]++;
+
+        const auto candidates = pir_batch.get_candidate_buckets(hash_evals[key]);
+        EXPECT_NE(std::find(candidates.begin(), candidates.end(), bucket), candidates.end());
+
+        const auto [slot_begin, slot_end] = pir_batch.get_bucket_slots(bucket);
+        for (const auto slot : hash_evals[key]) {
+          EXPECT_GE(slot, slot_begin);
+          EXPECT_LT(slot, slot_end);
+        }
+      }
+      EXPECT_TRUE(std::all_of(num_buckets_of_key.begin(), num_buckets_of_key.end(), [](const size_t n) { return n == 1; }));
+
+      EXPECT_TRUE(pir_batch.query(hash_evals, key_of_bucket, batch_query));
+      EXPECT_TRUE(pir_batch.answer(fingerprints_mod_p, batch_query, answers));
+      EXPECT_TRUE(pir_batch.decode(key_fingerprints, key_of_bucket, answers, recovered));
+
+      EXPECT_TRUE(std::equal(recovered.begin(), recovered.end(), batch_values.begin()));
+    }
+
+    EXPECT_GE(num_assigned_batches, (num_batches * 9) / 10);
+
+    // A batch can't have more keys than buckets.
+    std::vector<std::array<uint32_t, 3>> too_many_hash_evals(pir_batch.num_buckets() + 1, hash_evals[0]);
+    EXPECT_FALSE(pir_batch.assign(too_many_hash_evals, key_of_bucket));
+
+    std::vector<uint32_t> short_answers(pir_batch.num_buckets() - 1);
+    EXPECT_FALSE(pir_batch.answer(fingerprints_mod_p, batch_query, short_answers));
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that a PIR batch with a single bucket covers the whole fingerprint array, answering one key per pass, as when queried one key at a time.
+TEST(PIRBatchForKVMap, SingleBucketCoversWholeFingerprintArray)
+{
+  constexpr size_t size = 10'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+    bff_kv_map::bff_for_kv_map_pir_batch_t pir_batch(filter, 1);
+
+    const auto fingerprints_mod_p = filter.get_fingerprints_mod_p();
+    EXPECT_EQ(pir_batch.num_buckets(), 1);
+    EXPECT_EQ(pir_batch.query_num_elements(), fingerprints_mod_p.size());
+
+    const std::array<std::array<uint32_t, 3>, 1> hash_evals{ filter.get_hash_evals(keys[0]) };
+    const std::array<uint64_t, 1> key_fingerprints{ filter.get_key_fingerprint(keys[0]) };
+    std::array<uint32_t, 1> key_of_bucket{};
+    std::vector<uint32_t> batch_query(pir_batch.query_num_elements());
+    std::array<uint32_t, 1> answers{};
+    std::array<uint32_t, 1> recovered{};
+
+    EXPECT_TRUE(pir_batch.assign(hash_evals, key_of_bucket));
+    EXPECT_TRUE(pir_batch.query(hash_evals, key_of_bucket, batch_query));
+    EXPECT_TRUE(pir_batch.answer(fingerprints_mod_p, batch_query, answers));
+    EXPECT_TRUE(pir_batch.decode(key_fingerprints, key_of_bucket, answers, recovered));
+    EXPECT_EQ(recovered[0], values[0]);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that a PIR batch can't be laid out over an empty filter, or with zero buckets.
+TEST(PIRBatchForKVMap, AttemptPIRBatchWithZeroBuckets)
+{
+  try {
+    bff_kv_map::bff_for_kv_map_t filter;
+    bff_kv_map::bff_for_kv_map_pir_batch_t pir_batch(filter, 0);
+
+    EXPECT_TRUE(false);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "PIR batch needs a non-empty Binary Fuse Filter and at least one bucket.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
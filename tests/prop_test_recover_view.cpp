@@ -0,0 +1,118 @@
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/local_filter_for_kv_map.hpp"
+#include "binary_fuse_filter/recover_view.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <cstring>
+#include <gtest/gtest.h>
+#include <ranges>
+#include <stdexcept>
+
+// Tests that recovering values in batches returns the same values as recovering them one by one, including for a partial trailing batch.
+TEST(RecoverView, RecoverBatchMatchesRecover)
+{
+  constexpr size_t size = 100'003;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+    std::vector<uint32_t> recovered(size, 0);
+    EXPECT_TRUE(filter.recover_batch(keys, recovered));
+    EXPECT_EQ(values, recovered);
+
+    EXPECT_FALSE(filter.recover_batch(keys, std::span(recovered).first(size - 1)));
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that the range adaptor lazily yields values for keys of sized and unsized input ranges, in order, when composed with standard range adaptors.
+TEST(RecoverView, RecoverValuesWhenQueriedUsingKeysInRangePipeline)
+{
+  constexpr size_t size = 100'003;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+    auto recovered_view = keys | bff_kv_map::views::recover(filter);
+    EXPECT_EQ(recovered_view.size(), size);
+
+    size_t key_idx = 0;
+    for (const uint32_t recovered : recovered_view) {
+      EXPECT_EQ(values[key_idx], recovered);
+      key_idx++;
+    }
+    EXPECT_EQ(key_idx, size);
+
+    // Every third key, through a view which isn't sized, and values transformed further down the pipeline.
+    const auto is_kept = [&](const bff_kv_map_utils::bff_key_t& key) { return ((&key - keys.data()) % 3) == 0; };
+    auto recovered_doubled_view = keys | std::views::filter(is_kept) | bff_kv_map::views::recover(filter) |
+                                  std::views::transform([](const uint32_t value) { return value * 2; });
+
+    key_idx = 0;
+    for (const uint32_t recovered_doubled : recovered_doubled_view) {
+      EXPECT_EQ(values[key_idx] * 2, recovered_doubled);
+      key_idx += 3;
+    }
+    EXPECT_EQ(key_idx, ((size + 2) / 3) * 3);
+
+    auto empty_view = bff_kv_map::views::recover(std::span(keys).first(0), filter);
+    EXPECT_TRUE(empty_view.begin() == std::default_sentinel);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that values of a cache- and TLB-local filter, recovered through the range adaptor, include those of stashed keys.
+TEST(RecoverView, RecoverValuesOfLocalFilterIncludingStashedKeys)
+{
+  constexpr size_t size = 100'000;
+  constexpr size_t max_num_attempts = 16;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    // Only a few keys are stashed at this size, sometimes none, so seeds are retried until some are.
+    bff_kv_map::bff_for_kv_map_local_t filter;
+    for (size_t attempt = 0; (attempt < max_num_attempts) && (filter.stash_size() == 0); attempt++) {
+      filter = bff_kv_map::bff_for_kv_map_local_t(generate_random_seed(), keys, values, plaintext_modulo, label);
+    }
+    EXPECT_GT(filter.stash_size(), 0);
+
+    size_t key_idx = 0;
+    for (const uint32_t recovered : keys | bff_kv_map::views::recover(filter)) {
+      EXPECT_EQ(values[key_idx], recovered);
+      key_idx++;
+    }
+    EXPECT_EQ(key_idx, size);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
@@ -0,0 +1,117 @@
+#include "binary_fuse_filter/ribbon_for_kv_map.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <cmath>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+
+// Tests that a ribbon retrieval can be created, and that querying it with keys returns the correct values, including bumped keys.
+TEST(RibbonForKVMap, CreateRibbonAndRecoverValuesWhenQueriedUsingKeys)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::ribbon_for_kv_map_t ribbon(seed, keys, values, plaintext_modulo, label);
+
+    for (size_t i = 0; i < size; i++) {
+      const uint32_t recovered = ribbon.recover(keys[i]);
+      EXPECT_EQ(values[i], recovered);
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Ribbon Retrieval for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that a ribbon retrieval can be serialized and deserialized, and that querying it with keys returns the correct values.
+TEST(RibbonForKVMap, SerializeAndDeserializeRibbon)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1UL << 32;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::ribbon_for_kv_map_t ribbon(seed, keys, values, plaintext_modulo, label);
+
+    std::vector<uint8_t> ribbon_as_bytes(ribbon.serialized_num_bytes());
+    EXPECT_TRUE(ribbon.serialize(ribbon_as_bytes));
+
+    bff_kv_map::ribbon_for_kv_map_t ribbon_from_bytes(ribbon_as_bytes);
+
+    for (size_t i = 0; i < size; i++) {
+      const uint32_t recovered_ribbon1 = ribbon.recover(keys[i]);
+      const uint32_t recovered_ribbon2 = ribbon_from_bytes.recover(keys[i]);
+
+      EXPECT_EQ(recovered_ribbon1, recovered_ribbon2);
+      EXPECT_EQ(values[i], recovered_ribbon1);
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Ribbon Retrieval for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that the bits-per-entry of ribbon retrieval is less than log2(plaintext_modulo) + 1, which binary fuse filter can't achieve.
+TEST(RibbonForKVMap, CheckBitsPerEntry)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::ribbon_for_kv_map_t ribbon(seed, keys, values, plaintext_modulo, label);
+
+    const size_t bpe = ribbon.bits_per_entry();
+    EXPECT_LT(bpe, std::log2(plaintext_modulo) + 1);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Ribbon Retrieval for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that attempting to construct a ribbon retrieval with plaintext modulo, which is not a power of 2, throws an exception.
+TEST(RibbonForKVMap, AttemptConstructionWithPlainTextModuloNotPowerOf2)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1000;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::ribbon_for_kv_map_t ribbon(seed, keys, values, plaintext_modulo, label);
+    EXPECT_TRUE(false);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Plaintext modulo must be a power of 2, <= 2^32.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
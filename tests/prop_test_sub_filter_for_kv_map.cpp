@@ -0,0 +1,120 @@
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/sub_filter_for_kv_map.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <vector>
+
+// Tests that a sub-filter can be extracted for a subset of keys, and that querying its view with those keys returns the correct values.
+TEST(SubFilterForKVMap, ExtractSubFilterAndRecoverValuesWhenQueriedUsingKeys)
+{
+  constexpr size_t size = 100'000;
+  constexpr size_t sub_size = 1'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+    const auto sub_keys = std::span(keys).first(sub_size);
+    const auto sub_filter_as_bytes = filter.extract_sub_filter(sub_keys);
+
+    EXPECT_LT(sub_filter_as_bytes.size(), filter.serialized_num_bytes() / 10);
+
+    bff_kv_map::bff_for_kv_map_sub_filter_view_t sub_filter(sub_filter_as_bytes);
+    EXPECT_LE(sub_filter.num_fingerprints(), sub_size * 3 * (1 + bff_kv_map::BFF_FOR_KV_MAP_SUB_FILTER_MAX_SLOT_GAP));
+
+    for (size_t i = 0; i < sub_size; i++) {
+      const auto recovered = sub_filter.recover(keys[i]);
+
+      EXPECT_TRUE(recovered.has_value());
+      EXPECT_EQ(values[i], recovered.value_or(0));
+    }
+
+    size_t num_recovered_outside_subset = 0;
+    for (size_t i = sub_size; i < size; i++) {
+      num_recovered_outside_subset += sub_filter.recover(keys[i]).has_value() ? 1 : 0;
+    }
+
+    EXPECT_LT(num_recovered_outside_subset, (size - sub_size) / 100);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that attempting to view a truncated sub-filter throws an exception.
+TEST(SubFilterForKVMap, AttemptViewingTruncatedSubFilter)
+{
+  constexpr size_t size = 10'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+    const auto sub_filter_as_bytes = filter.extract_sub_filter(std::span(keys).first(100));
+    const auto truncated_sub_filter_as_bytes = std::span(sub_filter_as_bytes).first(sub_filter_as_bytes.size() - 1);
+    bff_kv_map::bff_for_kv_map_sub_filter_view_t sub_filter(truncated_sub_filter_as_bytes);
+
+    EXPECT_TRUE(false);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Serialized sub-filter is malformed.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that attempting to view a sub-filter, whose header holds a zero plaintext modulo, or an inconsistent segment layout, throws an exception.
+TEST(SubFilterForKVMap, AttemptViewingSubFilterWithCorruptHeader)
+{
+  constexpr size_t size = 10'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  // Offsets of plaintext modulo and segment count in the header, see `bff_for_kv_map_t::serialize`.
+  constexpr size_t plaintext_modulo_offset = 32 + sizeof(uint32_t);
+  constexpr size_t segment_count_offset = plaintext_modulo_offset + sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+    const auto sub_filter_as_bytes = filter.extract_sub_filter(std::span(keys).first(100));
+
+    std::vector<uint8_t> zero_modulo_sub_filter_as_bytes(sub_filter_as_bytes);
+    const uint64_t zero_modulo = 0;
+    std::copy_n(reinterpret_cast<const uint8_t*>(&zero_modulo), sizeof(zero_modulo), zero_modulo_sub_filter_as_bytes.begin() + plaintext_modulo_offset);
+
+    std::vector<uint8_t> inconsistent_sub_filter_as_bytes(sub_filter_as_bytes);
+    inconsistent_sub_filter_as_bytes[segment_count_offset] += 1;
+
+    for (const auto& corrupt_sub_filter_as_bytes : { zero_modulo_sub_filter_as_bytes, inconsistent_sub_filter_as_bytes }) {
+      EXPECT_THROW(bff_kv_map::bff_for_kv_map_sub_filter_view_t sub_filter(corrupt_sub_filter_as_bytes), std::runtime_error);
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
@@ -0,0 +1,184 @@
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/tiered_filter_for_kv_map.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <thread>
+
+// Serializes given filter into a file in temporary directory, returning its path.
+static std::string
+write_filter_to_file(const bff_kv_map::bff_for_kv_map_t& filter, const std::string& file_name)
+{
+  std::vector<uint8_t> filter_as_bytes(filter.serialized_num_bytes());
+  filter.serialize(filter_as_bytes);
+
+  const auto file_path = (std::filesystem::temp_directory_path() / file_name).string();
+
+  std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+  file.write(reinterpret_cast<const char*>(filter_as_bytes.data()), static_cast<std::streamsize>(filter_as_bytes.size()));
+
+  return file_path;
+}
+
+// Tests that values are recovered correctly from a tiered filter, before and after frequently probed blocks are rebalanced into hot tier.
+TEST(TieredBinaryFuseFilterForKVMap, RecoverValuesWhenQueriedUsingKeysBeforeAndAfterRebalancing)
+{
+  constexpr size_t size = 100'000;
+  constexpr size_t hot_size = 10;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+  constexpr size_t max_hot_num_blocks = 16;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+    const auto file_path = write_filter_to_file(filter, "prop_test_tiered_filter_for_kv_map.bin");
+
+    bff_kv_map::bff_for_kv_map_tiered_t tiered_filter(file_path);
+    EXPECT_GT(tiered_filter.num_blocks_total(), max_hot_num_blocks);
+    EXPECT_EQ(tiered_filter.num_hot_blocks(), 0);
+    EXPECT_TRUE(tiered_filter.is_hot_tier_pinned());
+
+    for (size_t i = 0; i < size; i++) {
+      EXPECT_EQ(values[i], tiered_filter.recover(keys[i]));
+    }
+
+    // Skews probes towards a few keys, whose blocks should then be picked as hot.
+    for (size_t round = 0; round < 1'000; round++) {
+      for (size_t i = 0; i < hot_size; i++) {
+        EXPECT_EQ(values[i], tiered_filter.recover(keys[i]));
+      }
+    }
+
+    // Pinning may fail under `RLIMIT_MEMLOCK`, but has to be reported the same way by both.
+    const bool is_hot_tier_pinned = tiered_filter.rebalance(max_hot_num_blocks * bff_kv_map::BFF_FOR_KV_MAP_TIERED_BLOCK_NUM_FINGERPRINTS * sizeof(uint32_t));
+    EXPECT_EQ(is_hot_tier_pinned, tiered_filter.is_hot_tier_pinned());
+    EXPECT_GT(tiered_filter.num_hot_blocks(), 0);
+    EXPECT_LE(tiered_filter.num_hot_blocks(), max_hot_num_blocks);
+
+    std::vector<uint32_t> recovered(size, 0);
+    EXPECT_TRUE(tiered_filter.recover_batch(keys, recovered));
+    EXPECT_EQ(values, recovered);
+
+    std::filesystem::remove(file_path);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that queries keep recovering correct values, while tiers are being rebalanced concurrently, and replaced tier tables are being freed.
+TEST(TieredBinaryFuseFilterForKVMap, RecoverValuesWhileRebalancingConcurrently)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+    const auto file_path = write_filter_to_file(filter, "prop_test_tiered_filter_for_kv_map_concurrent.bin");
+
+    bff_kv_map::bff_for_kv_map_tiered_t tiered_filter(file_path);
+    std::atomic<bool> is_done{ false };
+
+    std::jthread rebalancer([&]() {
+      for (size_t round = 0; !is_done.load(); round++) {
+        tiered_filter.rebalance((round % 32) * bff_kv_map::BFF_FOR_KV_MAP_TIERED_BLOCK_NUM_FINGERPRINTS * sizeof(uint32_t));
+        std::this_thread::yield();
+      }
+    });
+
+    std::vector<uint32_t> recovered(size, 0);
+    for (size_t round = 0; round < 4; round++) {
+      for (size_t i = 0; i < size; i++) {
+        EXPECT_EQ(values[i], tiered_filter.recover(keys[i]));
+      }
+
+      EXPECT_TRUE(tiered_filter.recover_batch(keys, recovered));
+      EXPECT_EQ(values, recovered);
+    }
+
+    is_done.store(true);
+    rebalancer.join();
+
+    std::filesystem::remove(file_path);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that viewing a filter file, which doesn't exist, fails.
+TEST(TieredBinaryFuseFilterForKVMap, AttemptViewingMissingFile)
+{
+  try {
+    bff_kv_map::bff_for_kv_map_tiered_t tiered_filter((std::filesystem::temp_directory_path() / "prop_test_tiered_filter_for_kv_map_missing.bin").string());
+    EXPECT_TRUE(false);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to open filter file.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
+
+// Tests that viewing a filter file, whose header holds a zero plaintext modulo, or an inconsistent segment layout, fails.
+TEST(TieredBinaryFuseFilterForKVMap, AttemptViewingFileWithCorruptHeader)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  // Offsets of plaintext modulo and segment count in the header, see `bff_for_kv_map_t::serialize`.
+  constexpr size_t plaintext_modulo_offset = 32 + sizeof(uint32_t);
+  constexpr size_t segment_count_offset = plaintext_modulo_offset + sizeof(uint64_t) + sizeof(uint64_t) + sizeof(uint32_t);
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+    const auto file_path = write_filter_to_file(filter, "prop_test_tiered_filter_for_kv_map_corrupt.bin");
+
+    const auto overwrite_file_at = [&](const size_t offset, const auto field) {
+      std::fstream file(file_path, std::ios::binary | std::ios::in | std::ios::out);
+      file.seekp(static_cast<std::streamoff>(offset));
+      file.write(reinterpret_cast<const char*>(&field), sizeof(field));
+    };
+
+    overwrite_file_at(plaintext_modulo_offset, uint64_t{ 0 });
+    EXPECT_THROW(bff_kv_map::bff_for_kv_map_tiered_t tiered_filter(file_path), std::runtime_error);
+
+    // A single segment no longer matches segment count length, or number of fingerprints, of a filter over this many keys.
+    write_filter_to_file(filter, "prop_test_tiered_filter_for_kv_map_corrupt.bin");
+    overwrite_file_at(segment_count_offset, uint32_t{ 1 });
+    EXPECT_THROW(bff_kv_map::bff_for_kv_map_tiered_t tiered_filter(file_path), std::runtime_error);
+
+    std::filesystem::remove(file_path);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
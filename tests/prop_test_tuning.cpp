@@ -0,0 +1,123 @@
+#include "binary_fuse_filter/autotune.hpp"
+#include "binary_fuse_filter/filter_for_kv_map.hpp"
+#include "binary_fuse_filter/tuning.hpp"
+#include "binary_fuse_filter/utils.hpp"
+#include "test_utils.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <gtest/gtest.h>
+#include <limits>
+#include <stdexcept>
+
+// Tests that tuning parameters survive a round trip through a tuning file, while out of range values are clamped, and malformed files are rejected.
+TEST(TuningForBinaryFuseFilterForKVMap, SaveAndLoadTuningFile)
+{
+  const auto file_path = (std::filesystem::temp_directory_path() / "prop_test_tuning.tuning").string();
+  const auto tuning_in_effect = bff_kv_map::get_tuning();
+
+  constexpr bff_kv_map::tuning_t tuning{ .recover_batch_size = 64, .construction_prefetch_distance = 8 };
+  EXPECT_TRUE(bff_kv_map::save_tuning(file_path, tuning));
+  EXPECT_TRUE(bff_kv_map::load_tuning(file_path));
+  EXPECT_EQ(bff_kv_map::get_tuning(), tuning);
+
+  {
+    std::ofstream file(file_path, std::ios::trunc);
+    file << "recover_batch_size=100000\nconstruction_prefetch_distance=100000\nsome_future_parameter=1\n";
+  }
+
+  bff_kv_map::tuning_t clamped_tuning{};
+  EXPECT_TRUE(bff_kv_map::read_tuning(file_path, clamped_tuning));
+  EXPECT_EQ(clamped_tuning.recover_batch_size, bff_kv_map::BFF_FOR_KV_MAP_MAX_RECOVER_BATCH_SIZE);
+  EXPECT_EQ(clamped_tuning.construction_prefetch_distance, bff_kv_map::BFF_FOR_KV_MAP_MAX_CONSTRUCTION_PREFETCH_DISTANCE);
+
+  {
+    std::ofstream file(file_path, std::ios::trunc);
+    file << "recover_batch_size=sixty four\n";
+  }
+
+  EXPECT_FALSE(bff_kv_map::load_tuning(file_path));
+  EXPECT_EQ(bff_kv_map::get_tuning(), tuning);
+
+  std::filesystem::remove(file_path);
+  EXPECT_FALSE(bff_kv_map::load_tuning(file_path));
+
+  bff_kv_map::set_tuning(tuning_in_effect);
+}
+
+// Tests that filters built and values recovered are the same, under any tuning parameters, as tuning must only affect performance.
+TEST(TuningForBinaryFuseFilterForKVMap, TuningDoesNotAffectFiltersOrRecoveredValues)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1024;
+  constexpr uint64_t label = 1;
+
+  const auto tuning_in_effect = bff_kv_map::get_tuning();
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint32_t> values(size, 0);
+  generate_random_keys_and_values(keys, values, plaintext_modulo);
+
+  try {
+    bff_kv_map::set_tuning({ .recover_batch_size = 1, .construction_prefetch_distance = 0 });
+    bff_kv_map::bff_for_kv_map_t expected_filter(seed, keys, values, plaintext_modulo, label);
+
+    std::vector<uint8_t> expected_filter_as_bytes(expected_filter.serialized_num_bytes());
+    EXPECT_TRUE(expected_filter.serialize(expected_filter_as_bytes));
+
+    for (const auto tuning : { bff_kv_map::tuning_t{ 7, 4 }, bff_kv_map::tuning_t{ 32, 16 }, bff_kv_map::tuning_t{ 128, 64 } }) {
+      bff_kv_map::set_tuning(tuning);
+
+      bff_kv_map::bff_for_kv_map_t filter(seed, keys, values, plaintext_modulo, label);
+
+      std::vector<uint8_t> filter_as_bytes(filter.serialized_num_bytes());
+      EXPECT_TRUE(filter.serialize(filter_as_bytes));
+      EXPECT_EQ(filter_as_bytes, expected_filter_as_bytes);
+
+      std::vector<uint32_t> recovered(size, 0);
+      EXPECT_TRUE(filter.recover_batch(keys, recovered));
+      EXPECT_EQ(recovered, values);
+    }
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+
+  bff_kv_map::set_tuning(tuning_in_effect);
+}
+
+// Tests that autotuning picks among candidate values, while leaving tuning in effect unchanged.
+TEST(TuningForBinaryFuseFilterForKVMap, AutotunePicksCandidateValues)
+{
+  const auto tuning_in_effect = bff_kv_map::get_tuning();
+  const auto tuning = bff_kv_map::autotune(1UL << 16, 1UL << 17);
+
+  EXPECT_NE(std::find(bff_kv_map::BFF_FOR_KV_MAP_AUTOTUNE_RECOVER_BATCH_SIZES.begin(),
+                      bff_kv_map::BFF_FOR_KV_MAP_AUTOTUNE_RECOVER_BATCH_SIZES.end(),
+                      tuning.recover_batch_size),
+            bff_kv_map::BFF_FOR_KV_MAP_AUTOTUNE_RECOVER_BATCH_SIZES.end());
+  EXPECT_NE(std::find(bff_kv_map::BFF_FOR_KV_MAP_AUTOTUNE_CONSTRUCTION_PREFETCH_DISTANCES.begin(),
+                      bff_kv_map::BFF_FOR_KV_MAP_AUTOTUNE_CONSTRUCTION_PREFETCH_DISTANCES.end(),
+                      tuning.construction_prefetch_distance),
+            bff_kv_map::BFF_FOR_KV_MAP_AUTOTUNE_CONSTRUCTION_PREFETCH_DISTANCES.end());
+  EXPECT_EQ(bff_kv_map::get_tuning(), tuning_in_effect);
+}
+
+// Tests that autotuning restores tuning in effect, when it throws after having changed it.
+TEST(TuningForBinaryFuseFilterForKVMap, AutotuneRestoresTuningWhenThrowing)
+{
+  const auto tuning_in_effect = bff_kv_map::get_tuning();
+
+  try {
+    // Batch sizes get timed first, before keys of the filter, whose construction is timed, fail to be allocated.
+    bff_kv_map::autotune(1UL << 16, std::numeric_limits<size_t>::max());
+    EXPECT_TRUE(false);
+  } catch (std::length_error& err) {
+  }
+
+  EXPECT_EQ(bff_kv_map::get_tuning(), tuning_in_effect);
+}
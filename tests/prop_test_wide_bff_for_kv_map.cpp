@@ -0,0 +1,71 @@
+#include "binary_fuse_filter/utils.hpp"
+#include "binary_fuse_filter/wide_filter_for_kv_map.hpp"
+#include "test_utils.hpp"
+#include <array>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <stdexcept>
+#include <tuple>
+
+// Tests that a wide value filter can be created, and that querying it with keys returns the correct values, for various limb bases and bit widths.
+TEST(WideBinaryFuseFilterForKVMap, CreateFilterAndRecoverWideValuesWhenQueriedUsingKeys)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t label = 1;
+
+  // (plaintext modulo, value bit width, expected number of limbs)
+  constexpr std::array<std::tuple<uint64_t, uint32_t, uint32_t>, 4> params = { {
+    { 1UL << 16, 48, 3 },
+    { 1UL << 32, 64, 2 },
+    { 1024, 64, 7 },
+    { 1UL << 20, 20, 1 },
+  } };
+
+  for (const auto& [plaintext_modulo, value_bit_width, expected_num_limbs] : params) {
+    auto seed = generate_random_seed();
+    std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+    std::vector<uint64_t> values(size, 0);
+    generate_random_keys_and_wide_values(keys, values, value_bit_width);
+
+    try {
+      bff_kv_map::bff_for_kv_map_wide_t filter(seed, keys, values, plaintext_modulo, label, value_bit_width);
+      EXPECT_EQ(filter.get_num_limbs(), expected_num_limbs);
+
+      for (size_t i = 0; i < size; i++) {
+        const uint64_t recovered = filter.recover64(keys[i]);
+        EXPECT_EQ(values[i], recovered);
+      }
+    } catch (std::runtime_error& err) {
+      constexpr auto expected_err_msg = "Failed to construct Binary Fuse Filter for input Key-Value Map.";
+      const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+      EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+    }
+  }
+}
+
+// Tests that attempting to construct a wide value filter with values not fitting in the value bit width throws an exception.
+TEST(WideBinaryFuseFilterForKVMap, AttemptConstructionWithValuesWiderThanValueBitWidth)
+{
+  constexpr size_t size = 100'000;
+  constexpr uint64_t plaintext_modulo = 1UL << 16;
+  constexpr uint64_t label = 1;
+  constexpr uint32_t value_bit_width = 48;
+
+  auto seed = generate_random_seed();
+  std::vector<bff_kv_map_utils::bff_key_t> keys(size);
+  std::vector<uint64_t> values(size, 0);
+  generate_random_keys_and_wide_values(keys, values, value_bit_width);
+
+  values[size / 2] = 1UL << value_bit_width;
+
+  try {
+    bff_kv_map::bff_for_kv_map_wide_t filter(seed, keys, values, plaintext_modulo, label, value_bit_width);
+    EXPECT_TRUE(false);
+  } catch (std::runtime_error& err) {
+    constexpr auto expected_err_msg = "All values must fit in value bit width.";
+    const auto expected_err_msg_len = std::strlen(expected_err_msg);
+
+    EXPECT_EQ(std::memcmp(err.what(), expected_err_msg, expected_err_msg_len), 0);
+  }
+}
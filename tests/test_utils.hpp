@@ -1,7 +1,10 @@
 #pragma once
 #include "binary_fuse_filter/utils.hpp"
 #include <cstdint>
+#include <fstream>
 #include <random>
+#include <string>
+#include <string_view>
 
 static inline std::array<uint8_t, 32>
 generate_random_seed()
@@ -40,3 +43,40 @@ generate_random_keys_and_values(std::span<bff_kv_map_utils::bff_key_t> keys, std
     value = dist_u32(gen);
   }
 }
+
+// Generates random keys and wide values, each of given bit width.
+static inline void
+generate_random_keys_and_wide_values(std::span<bff_kv_map_utils::bff_key_t> keys, std::span<uint64_t> values, const uint32_t value_bit_width)
+{
+  std::random_device rd;
+  std::mt19937_64 gen(rd());
+
+  std::uniform_int_distribution<uint64_t> dist_u64;
+
+  for (auto& key : keys) {
+    key.words[0] = dist_u64(gen);
+    key.words[1] = dist_u64(gen);
+    key.words[2] = dist_u64(gen);
+    key.words[3] = dist_u64(gen);
+  }
+
+  for (auto& value : values) {
+    value = (value_bit_width == 64) ? dist_u64(gen) : (dist_u64(gen) >> (64 - value_bit_width));
+  }
+}
+
+// Reads a numeric field of `/proc/self/status`, such as "VmSize" ( in kB ) or "Threads", returning 0 if there's no such field.
+static inline size_t
+read_proc_self_status_field(std::string_view name)
+{
+  std::ifstream status("/proc/self/status");
+  std::string line;
+
+  while (std::getline(status, line)) {
+    if (line.starts_with(name) && (line.size() > name.size()) && (line[name.size()] == ':')) {
+      return std::stoul(line.substr(name.size() + 1));
+    }
+  }
+
+  return 0;
+}